@@ -0,0 +1,154 @@
+// AsyncSearch.hpp
+#pragma once
+
+#include "TicTacToe.hpp"
+
+#include <atomic>
+#include <thread>
+
+// Поиск хода в фоновом потоке: Start / Poll / Stop / Result.
+// Поиск идёт на собственной копии партии, поэтому вызывающий код может
+// свободно читать и менять свою доску, пока поток работает.
+//
+// Режим обдумывания (StartPonder): пока человек думает, движок
+// предсказывает его ответ и сразу ищет свой ход на него. Если человек
+// сыграл предсказанный ход, PonderHit отдаёт готовый ответ почти мгновенно.
+class AsyncSearch {
+private:
+    TicTacToeGame game_;
+    std::thread worker_;
+    std::atomic<bool> stop_;
+    std::atomic<bool> done_;
+    std::atomic<bool> predicted_;
+    std::atomic<bool> hasResult_;
+
+    Position result_;
+    Position prediction_;
+
+    void Launch(Cell opponent, Cell player, int depth, bool ponder) {
+        stop_.store(false);
+        done_.store(false);
+        predicted_.store(false);
+        hasResult_.store(false);
+        result_ = Position();
+        game_.SetStopFlag(&stop_);
+
+        worker_ = std::thread([this, opponent, player, depth, ponder]() {
+            if (Tracer::IsEnabled()) {
+                Tracer::SetThreadName("async search");
+            }
+            {
+                TraceScope trace(ponder ? "Ponder" : "AsyncSearch", "worker",
+                                 depth);
+                if (ponder) {
+                    // Ответ соперника предсказываем на ход мельче
+                    Position guess = game_.FindBestMove(
+                        opponent, depth > 1 ? depth - 1 : 1);
+                    if (!game_.WasSearchAborted()) {
+                        prediction_ = guess;
+                        game_.MakeMove(guess.x, guess.y, opponent);
+                        predicted_.store(true, std::memory_order_release);
+                    }
+                }
+                if (!ponder || predicted_.load(std::memory_order_relaxed)) {
+                    result_ = game_.FindBestMove(player, depth);
+                    hasResult_.store(true, std::memory_order_relaxed);
+                }
+            }
+            done_.store(true, std::memory_order_release);
+        });
+    }
+
+public:
+    AsyncSearch()
+        : game_(), stop_(false), done_(true), predicted_(false),
+          hasResult_(false), result_(), prediction_() {}
+
+    ~AsyncSearch() {
+        Stop();
+    }
+
+    AsyncSearch(const AsyncSearch&) = delete;
+    AsyncSearch& operator=(const AsyncSearch&) = delete;
+
+    // Запуск поиска хода player в позиции game
+    void Start(const TicTacToeGame& game, Cell player, int depth) {
+        Stop();
+        game_ = game;
+        Launch(EMPTY, player, depth, /*ponder=*/false);
+    }
+
+    // Обдумывание: opponent сейчас на ходу, player отвечает ему
+    void StartPonder(const TicTacToeGame& game, Cell opponent, Cell player,
+                     int depth) {
+        Stop();
+        game_ = game;
+        Launch(opponent, player, depth, /*ponder=*/true);
+    }
+
+    // true — поиск завершён (или не запускался)
+    [[nodiscard]] bool Poll() const {
+        return done_.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] bool IsRunning() const {
+        return worker_.joinable() && !Poll();
+    }
+
+    // Прервать поиск и дождаться потока
+    void Stop() {
+        if (worker_.joinable()) {
+            stop_.store(true);
+            worker_.join();
+        }
+    }
+
+    // Дождаться завершения и вернуть найденный ход. После Stop это
+    // лучший из готовых корневых ходов или первый кандидат (свободная
+    // клетка); если ход не искался вовсе — см. HasResult.
+    [[nodiscard]] Position Result() {
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+        return result_;
+    }
+
+    // Есть ли ход в Result(): нет, если обдумывание остановлено до
+    // предсказания ответа соперника
+    [[nodiscard]] bool HasResult() {
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+        return hasResult_.load(std::memory_order_relaxed);
+    }
+
+    // Завершился ли поиск полностью, без остановки
+    [[nodiscard]] bool IsComplete() const {
+        return Poll() && !game_.WasSearchAborted();
+    }
+
+    // Проверка предсказания после реального хода соперника.
+    // При совпадении дожидается ответа и возвращает его в reply.
+    bool PonderHit(const Position& opponentMove, Position& reply) {
+        // Соперник мог сходить раньше, чем готово предсказание:
+        // предсказание считается на ход мельче, так что ждать недолго
+        while (!predicted_.load(std::memory_order_acquire) && !Poll()) {
+            std::this_thread::yield();
+        }
+
+        if (!predicted_.load(std::memory_order_acquire) ||
+            !(prediction_ == opponentMove)) {
+            Stop();
+            return false;
+        }
+
+        reply = Result();
+        return !game_.WasSearchAborted();
+    }
+
+    // Партия, на которой шёл поиск (например, чтобы забрать её таблицу
+    // транспозиций через TicTacToeGame::AdoptTranspositionTable)
+    TicTacToeGame& GetGame() {
+        return game_;
+    }
+};
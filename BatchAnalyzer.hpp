@@ -0,0 +1,270 @@
+// BatchAnalyzer.hpp
+#pragma once
+
+#include "TicTacToe.hpp"
+#include "PositionSuite.hpp"
+#include "DynamicArray.hpp"
+#include "Trace.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+struct AnalysisSettings {
+    int depth = 3;
+    int timeLimitMs = 0;        // > 0 — итеративное углубление до depth
+    std::size_t threads = 0;    // 0 — по числу ядер
+    std::size_t window = 0;     // позиций в работе; 0 — 4 на поток
+    int winLength = 5;
+    // Чистая таблица транспозиций для каждой позиции: результат не
+    // зависит от того, какой поток и после чего её считал
+    bool freshTable = true;
+    // > 0 — столько лучших ходов (FindBestMoves) в столбце lines;
+    // timeLimitMs тогда не действует
+    std::size_t multiPv = 0;
+    SearchConfig search;
+    EvalWeights weights;
+};
+
+struct AnalysisResult {
+    enum Status {
+        OK,
+        INVALID,        // строку не удалось разобрать или ход незаконен
+        FINISHED        // в позиции уже есть победитель
+    };
+
+    std::size_t line = 0;       // номер строки во входном файле, с 1
+    Status status = OK;
+    Cell toMove = EMPTY;
+    Position move;
+    int score = 0;
+    int depth = 0;
+    SearchStats stats;
+    double ms = 0.0;
+    DynamicArray<PrincipalVariation> lines;     // при multiPv > 0
+};
+
+// Пакетный анализ позиций: поток строк (каждая — запись партии в формате
+// ParseMoveList, пустые строки и строки с '#' пропускаются) проходит
+// разбор → поиск → запись.
+//
+// Вызывающий поток читает вход, рабочие потоки ищут, каждый на своём
+// TicTacToeGame. Строки ждут в кольце из window ячеек: новая строка
+// читается, только когда освободилась ячейка самой старой ещё не
+// записанной, поэтому память не зависит от размера входа. Готовый
+// результат пишет тот рабочий, чья позиция оказалась следующей по
+// порядку, — вывод идёт в порядке входа.
+class BatchAnalyzer {
+private:
+    struct Slot {
+        std::string text;
+        AnalysisResult result;
+        bool done = false;
+    };
+
+    struct Pipeline {
+        std::mutex mutex;
+        std::condition_variable changed;
+        DynamicArray<Slot> slots;
+        std::size_t nextRead = 0;       // номер следующей прочитанной строки
+        std::size_t nextTake = 0;       // ... взятой в работу
+        std::size_t nextWrite = 0;      // ... записанной
+        bool inputDone = false;
+    };
+
+    static void Worker(Pipeline& p, std::ostream& out,
+                       const AnalysisSettings& settings) {
+        TicTacToeGame game(settings.winLength);
+        game.SetSearchConfig(settings.search);
+        game.SetEvalWeights(settings.weights);
+        const std::size_t window = p.slots.size();
+
+        while (true) {
+            std::size_t index = 0;
+            std::string text;
+            std::size_t line = 0;
+            {
+                std::unique_lock<std::mutex> lock(p.mutex);
+                p.changed.wait(lock, [&p]() {
+                    return p.nextTake < p.nextRead || p.inputDone;
+                });
+                if (p.nextTake == p.nextRead) {
+                    return;
+                }
+                index = p.nextTake++;
+                Slot& slot = p.slots[index % window];
+                text.swap(slot.text);
+                line = slot.result.line;
+            }
+
+            AnalysisResult result = Analyze(game, text, line, settings);
+
+            std::lock_guard<std::mutex> lock(p.mutex);
+            Slot& slot = p.slots[index % window];
+            slot.result = result;
+            slot.done = true;
+            while (p.nextWrite < p.nextTake &&
+                   p.slots[p.nextWrite % window].done) {
+                Slot& ready = p.slots[p.nextWrite % window];
+                WriteResult(out, ready.result, settings.multiPv > 0);
+                ready.done = false;
+                ++p.nextWrite;
+            }
+            p.changed.notify_all();
+        }
+    }
+
+public:
+    // Одна позиция; game переиспользуется между вызовами
+    static AnalysisResult Analyze(TicTacToeGame& game,
+                                  const std::string& text, std::size_t line,
+                                  const AnalysisSettings& settings) {
+        TraceScope trace("AnalyzePosition", "worker",
+                         static_cast<std::int64_t>(line));
+        AnalysisResult result;
+        result.line = line;
+
+        DynamicArray<Position> moves;
+        game.Reset();
+        if (!ParseMoveList(text, moves)) {
+            result.status = AnalysisResult::INVALID;
+            return result;
+        }
+        result.toMove = PlayMoveList(game, moves);
+        if (result.toMove == EMPTY) {
+            result.status = AnalysisResult::INVALID;
+            return result;
+        }
+        if (game.CheckWin(X) || game.CheckWin(O)) {
+            result.status = AnalysisResult::FINISHED;
+            return result;
+        }
+        if (settings.freshTable) {
+            game.ClearTranspositionTable();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        if (settings.multiPv > 0) {
+            result.lines = game.FindBestMoves(result.toMove, settings.depth,
+                                              settings.multiPv);
+            if (!result.lines.empty()) {
+                result.move = result.lines[0].move;
+            }
+            result.depth = game.GetCompletedDepth();
+        } else if (settings.timeLimitMs > 0) {
+            result.move = game.FindBestMoveTimed(
+                result.toMove, std::chrono::milliseconds(settings.timeLimitMs),
+                settings.depth);
+            result.depth = game.GetCompletedDepth();
+        } else {
+            result.move = game.FindBestMove(result.toMove, settings.depth);
+            result.depth = settings.depth;
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        result.score = game.GetLastScore();
+        result.stats = game.GetSearchStats();
+        result.ms =
+            std::chrono::duration<double, std::milli>(end - start).count();
+        return result;
+    }
+
+    // withLines — столбец lines (AnalysisSettings::multiPv): линии через
+    // ';', каждая — "оценка:x,y x,y ..." (главный вариант), в кавычках
+    static void WriteHeader(std::ostream& out, bool withLines = false) {
+        out << "line,status,to_move,x,y,score,depth,nodes,leaves,cutoffs,"
+               "first_move_cutoff_rate,ebf,ms"
+            << (withLines ? ",lines\n" : "\n");
+    }
+
+    static void WriteResult(std::ostream& out, const AnalysisResult& r,
+                            bool withLines = false) {
+        static const char* statusNames[] = { "ok", "invalid", "finished" };
+        out << r.line << ',' << statusNames[r.status] << ',';
+        if (r.status != AnalysisResult::OK) {
+            out << (withLines ? ",,,,,,,,,,,\n" : ",,,,,,,,,,\n");
+            return;
+        }
+        out << (r.toMove == X ? 'X' : 'O') << ',' << r.move.x << ','
+            << r.move.y << ',' << r.score << ',' << r.depth << ','
+            << r.stats.nodes << ',' << r.stats.leafEvaluations << ','
+            << r.stats.cutoffs << ',' << r.stats.FirstMoveCutoffRate() << ','
+            << r.stats.EffectiveBranchingFactor() << ',' << r.ms;
+        if (withLines) {
+            out << ",\"";
+            for (std::size_t i = 0; i < r.lines.size(); ++i) {
+                out << (i > 0 ? ";" : "") << r.lines[i].score << ':';
+                for (std::size_t j = 0; j < r.lines[i].line.size(); ++j) {
+                    const Position& m = r.lines[i].line[j];
+                    out << (j > 0 ? " " : "") << m.x << ',' << m.y;
+                }
+            }
+            out << '"';
+        }
+        out << '\n';
+    }
+
+    // Анализирует все позиции из in, пишет заголовок и строку на каждую
+    // позицию в out. Возвращает число позиций.
+    static std::size_t Run(std::istream& in, std::ostream& out,
+                           const AnalysisSettings& settings) {
+        std::size_t threads = settings.threads;
+        if (threads == 0) {
+            threads = std::thread::hardware_concurrency();
+            if (threads == 0) {
+                threads = 1;
+            }
+        }
+        std::size_t window = settings.window > 0 ? settings.window
+                                                 : threads * 4;
+
+        Pipeline p;
+        p.slots = DynamicArray<Slot>(window);
+        for (std::size_t i = 0; i < window; ++i) {
+            p.slots.push_back(Slot());
+        }
+
+        WriteHeader(out, settings.multiPv > 0);
+
+        DynamicArray<std::thread> workers;
+        for (std::size_t i = 0; i < threads; ++i) {
+            workers.push_back(std::thread(
+                [&p, &out, &settings]() { Worker(p, out, settings); }));
+        }
+
+        std::string text;
+        std::size_t line = 0;
+        while (std::getline(in, text)) {
+            ++line;
+            std::size_t first = text.find_first_not_of(" \t\r");
+            if (first == std::string::npos || text[first] == '#') {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(p.mutex);
+            p.changed.wait(lock, [&p, window]() {
+                return p.nextRead - p.nextWrite < window;
+            });
+            Slot& slot = p.slots[p.nextRead % window];
+            slot.text.swap(text);
+            slot.result.line = line;
+            ++p.nextRead;
+            p.changed.notify_all();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(p.mutex);
+            p.inputDone = true;
+        }
+        p.changed.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        return p.nextWrite;
+    }
+};
@@ -0,0 +1,204 @@
+// Benchmark.hpp
+#pragma once
+
+#include "DynamicArray.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Не даёт компилятору выбросить вычисление, результат которого не используется
+template<typename T>
+inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+struct BenchResult {
+    std::string name;
+    std::size_t samples = 0;
+    std::size_t iterations = 0;     // вызовов на один замер
+    double medianNs = 0.0;          // на одну операцию
+    double p95Ns = 0.0;
+    double minNs = 0.0;
+};
+
+// Замеры: калибровка числа повторов, прогрев, серия замеров,
+// медиана и 95-й перцентиль в наносекундах на операцию.
+class BenchmarkRunner {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    DynamicArray<BenchResult> results_;
+    std::string filter_;
+    std::size_t samples_;
+    std::size_t warmupSamples_;
+    double targetSampleNs_;
+    bool quiet_;
+
+    template<typename F>
+    static double TimeCalls(F& fn, std::size_t iterations) {
+        auto start = Clock::now();
+        for (std::size_t i = 0; i < iterations; ++i) {
+            fn();
+        }
+        auto end = Clock::now();
+        return std::chrono::duration<double, std::nano>(end - start).count();
+    }
+
+public:
+    explicit BenchmarkRunner(std::size_t samples = 15,
+                             std::size_t warmupSamples = 3,
+                             double targetSampleNs = 2e6)
+        : results_(),
+          filter_(),
+          samples_(samples),
+          warmupSamples_(warmupSamples),
+          targetSampleNs_(targetSampleNs),
+          quiet_(false) {}
+
+    // Запускать только бенчмарки, в имени которых есть подстрока
+    void SetFilter(const std::string& filter) {
+        filter_ = filter;
+    }
+
+    // Не печатать строку на каждый замер (результаты — в GetResults)
+    void SetQuiet(bool quiet) {
+        quiet_ = quiet;
+    }
+
+    // Пройдёт ли бенчмарк с таким именем фильтр — чтобы не готовить
+    // дорогие данные для бенчмарков, которые всё равно не запустятся
+    [[nodiscard]] bool IsSelected(const std::string& name) const {
+        return filter_.empty() || name.find(filter_) != std::string::npos;
+    }
+
+    // fn выполняет opsPerCall операций; время делится на их число
+    template<typename F>
+    void Run(const std::string& name, F fn, std::size_t opsPerCall = 1) {
+        if (!IsSelected(name)) {
+            return;
+        }
+
+        // Калибровка: удваиваем число вызовов, пока замер не станет
+        // достаточно длинным для точности часов
+        std::size_t iterations = 1;
+        while (iterations < (std::size_t(1) << 30)) {
+            double ns = TimeCalls(fn, iterations);
+            if (ns >= targetSampleNs_) {
+                break;
+            }
+            iterations *= 2;
+        }
+
+        for (std::size_t i = 0; i < warmupSamples_; ++i) {
+            TimeCalls(fn, iterations);
+        }
+
+        DynamicArray<double> perOp(samples_);
+        const double ops = static_cast<double>(iterations * opsPerCall);
+        for (std::size_t i = 0; i < samples_; ++i) {
+            perOp.push_back(TimeCalls(fn, iterations) / ops);
+        }
+        std::sort(perOp.begin(), perOp.end());
+
+        BenchResult r;
+        r.name = name;
+        r.samples = samples_;
+        r.iterations = iterations;
+        r.medianNs = perOp[perOp.size() / 2];
+        r.p95Ns = perOp[std::min(perOp.size() - 1,
+                                 (perOp.size() * 95 + 99) / 100 - 1)];
+        r.minNs = perOp[0];
+        results_.push_back(r);
+
+        if (quiet_) {
+            return;
+        }
+        std::cout << name << ": median " << r.medianNs << " нс, p95 "
+                  << r.p95Ns << " нс\n";
+    }
+
+    [[nodiscard]] const DynamicArray<BenchResult>& GetResults() const {
+        return results_;
+    }
+
+    bool WriteCsv(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out.is_open()) {
+            return false;
+        }
+        out << "name,median_ns,p95_ns,min_ns,samples,iterations\n";
+        for (const auto& r : results_) {
+            out << r.name << ',' << r.medianNs << ',' << r.p95Ns << ','
+                << r.minNs << ',' << r.samples << ',' << r.iterations << '\n';
+        }
+        return static_cast<bool>(out);
+    }
+
+    bool WriteJson(const std::string& path) const {
+        std::ofstream out(path);
+        if (!out.is_open()) {
+            return false;
+        }
+        out << "{\n  \"benchmarks\": [\n";
+        for (std::size_t i = 0; i < results_.size(); ++i) {
+            const BenchResult& r = results_[i];
+            out << "    {\"name\": \"" << r.name << "\", \"median_ns\": "
+                << r.medianNs << ", \"p95_ns\": " << r.p95Ns
+                << ", \"min_ns\": " << r.minNs << ", \"samples\": "
+                << r.samples << ", \"iterations\": " << r.iterations << "}"
+                << (i + 1 < results_.size() ? ",\n" : "\n");
+        }
+        out << "  ]\n}\n";
+        return static_cast<bool>(out);
+    }
+
+    // Сравнение с сохранённым CSV (формат WriteCsv). Регрессия — медиана
+    // выросла больше чем в (1 + threshold) раз. Возвращает число регрессий.
+    int CompareWithBaseline(const std::string& path, double threshold) const {
+        std::ifstream in(path);
+        if (!in.is_open()) {
+            std::cout << "Не удалось открыть базовые результаты " << path
+                      << "\n";
+            return -1;
+        }
+
+        int regressions = 0;
+        std::string line;
+        std::getline(in, line);   // заголовок
+        while (std::getline(in, line)) {
+            std::istringstream fields(line);
+            std::string name, median;
+            if (!std::getline(fields, name, ',') ||
+                !std::getline(fields, median, ',')) {
+                continue;
+            }
+            double baseNs = std::stod(median);
+
+            for (const auto& r : results_) {
+                if (r.name != name) {
+                    continue;
+                }
+                double ratio = baseNs > 0 ? r.medianNs / baseNs : 1.0;
+                bool regressed = ratio > 1.0 + threshold;
+                if (regressed) {
+                    ++regressions;
+                }
+                std::cout << (regressed ? "РЕГРЕССИЯ " : "           ")
+                          << name << ": " << baseNs << " -> " << r.medianNs
+                          << " нс (x" << ratio << ")\n";
+            }
+        }
+        return regressions;
+    }
+};
@@ -0,0 +1,453 @@
+// ConcurrentHashTable.hpp
+#pragma once
+
+#include "DynamicArray.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+
+// Потокобезопасная хеш-таблица с тем же интерфейсом, что и HashTable.
+//
+// Ключи распределяются по 2^k шардам. Внутри шарда — открытая адресация
+// с линейным пробированием и «надгробиями» для удалённых ключей.
+//   - Запись (Add/Remove) берёт мьютекс своего шарда.
+//   - Чтение (Get/ContainsKey) не берёт блокировок: это seqlock. Писатель
+//     делает счётчик версии нечётным на время изменения, читатель
+//     повторяет попытку, если видел нечётную версию или версия поменялась.
+//   - Читатель на время чтения отмечается в счётчике своего потока:
+//     у каждого потока (до kReaderStripes, дальше по кругу) своя строка
+//     кэша, поэтому читатели не пишут в общую память — ни в строку
+//     шарда с версией и массивом, ни друг к другу. Счётчиков по два,
+//     по чётности «фазы» таблицы (как в SRCU). После перестройки шарда
+//     писатель, уже вернув версии чётность, но ещё под мьютексом,
+//     переключает фазу и ждёт, пока читатели старой фазы закончат:
+//     новые читатели входят в другую фазу и видят уже новый массив.
+//     После этого старый массив освобождается, так что память не
+//     растёт от чередования Add/Remove. Ждать недолго: чтение не
+//     блокируется, а версия в это время не меняется.
+//
+// Поля ячеек — std::atomic, поэтому TKey и TValue должны быть тривиально
+// копируемыми (Position, Cell, int и т.п.).
+template<typename TKey, typename TValue>
+class ConcurrentHashTable {
+    static_assert(std::is_trivially_copyable<TKey>::value,
+                  "ConcurrentHashTable requires a trivially copyable key");
+    static_assert(std::is_trivially_copyable<TValue>::value,
+                  "ConcurrentHashTable requires a trivially copyable value");
+
+private:
+    enum SlotState : std::uint8_t {
+        SLOT_EMPTY = 0,
+        SLOT_FULL = 1,
+        SLOT_DELETED = 2
+    };
+
+    struct Slot {
+        std::atomic<std::uint8_t> state;
+        std::atomic<TKey> key;
+        std::atomic<TValue> value;
+    };
+
+    struct Table {
+        Slot* slots;
+        std::size_t mask;
+    };
+
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::atomic<std::uint64_t> version;
+        std::atomic<Table*> table;
+        std::size_t count;        // только под мьютексом
+        std::size_t deleted;      // только под мьютексом
+
+        Shard() : version(0), table(nullptr), count(0), deleted(0) {}
+    };
+
+    // Счётчик читателей одного потока в одной фазе — на своей строке
+    struct alignas(64) ReaderCount {
+        std::atomic<std::size_t> count{0};
+    };
+
+    static constexpr std::size_t kReaderStripes = 16;
+
+    Shard* shards_;
+    std::size_t shardCount_;
+    unsigned shardBits_;
+    // Пишутся только писателями — отдельно от полей, которые читают все
+    alignas(64) std::atomic<std::size_t> count_;
+    std::atomic<std::size_t> allocatedSlots_;
+    // Читается каждым читателем, пишется только при освобождении массива
+    alignas(64) std::atomic<unsigned> phase_;
+    std::mutex reclaimMutex_;     // одно переключение фазы за раз
+    mutable ReaderCount readers_[2][kReaderStripes];
+    std::function<std::size_t(const TKey&)> hashFunc_;
+
+    static std::uint64_t Mix(std::uint64_t v) noexcept {
+        v ^= v >> 33;
+        v *= 0xff51afd7ed558ccdULL;
+        v ^= v >> 33;
+        v *= 0xc4ceb9fe1a85ec53ULL;
+        v ^= v >> 33;
+        return v;
+    }
+
+    Table* NewTable(std::size_t capacity) {
+        allocatedSlots_.fetch_add(capacity, std::memory_order_relaxed);
+        Table* t = new Table;
+        t->slots = new Slot[capacity];
+        t->mask = capacity - 1;
+        for (std::size_t i = 0; i < capacity; ++i) {
+            t->slots[i].state.store(SLOT_EMPTY, std::memory_order_relaxed);
+            t->slots[i].key.store(TKey{}, std::memory_order_relaxed);
+            t->slots[i].value.store(TValue{}, std::memory_order_relaxed);
+        }
+        return t;
+    }
+
+    void DeleteTable(Table* t) {
+        allocatedSlots_.fetch_sub(t->mask + 1, std::memory_order_relaxed);
+        delete[] t->slots;
+        delete t;
+    }
+
+    [[nodiscard]] std::uint64_t HashOf(const TKey& key) const {
+        return Mix(static_cast<std::uint64_t>(hashFunc_(key)));
+    }
+
+    Shard& ShardOf(std::uint64_t h) const {
+        return shards_[h & (shardCount_ - 1)];
+    }
+
+    std::size_t HomeSlot(std::uint64_t h, const Table* t) const {
+        return static_cast<std::size_t>(h >> shardBits_) & t->mask;
+    }
+
+    // Номер счётчика потока: раздаётся по кругу при первом чтении
+    static std::size_t ReaderStripe() noexcept {
+        static std::atomic<std::size_t> next{0};
+        thread_local const std::size_t stripe =
+            next.fetch_add(1, std::memory_order_relaxed) % kReaderStripes;
+        return stripe;
+    }
+
+    // Вход читателя: фаза перепроверяется после отметки, иначе писатель
+    // мог переключить её и не дождаться этого читателя. Массив шарда
+    // читается только после входа.
+    std::atomic<std::size_t>& EnterRead() const {
+        const std::size_t stripe = ReaderStripe();
+        for (;;) {
+            unsigned p = phase_.load(std::memory_order_seq_cst) & 1;
+            std::atomic<std::size_t>& readers = readers_[p][stripe].count;
+            readers.fetch_add(1, std::memory_order_seq_cst);
+            if ((phase_.load(std::memory_order_seq_cst) & 1) == p) {
+                return readers;
+            }
+            readers.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    static void LeaveRead(std::atomic<std::size_t>& readers) {
+        readers.fetch_sub(1, std::memory_order_release);
+    }
+
+    // Поиск без блокировок; found/value — снимок, согласованный по версии
+    bool ReadConsistent(const TKey& key, TValue* value) const {
+        const std::uint64_t h = HashOf(key);
+        const Shard& shard = ShardOf(h);
+        std::atomic<std::size_t>& readers = EnterRead();
+
+        for (;;) {
+            std::uint64_t v1 = shard.version.load(std::memory_order_acquire);
+            if (v1 & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            const Table* t = shard.table.load(std::memory_order_acquire);
+            bool found = false;
+            TValue result{};
+
+            std::size_t i = HomeSlot(h, t);
+            for (std::size_t probes = 0; probes <= t->mask; ++probes) {
+                std::uint8_t state =
+                    t->slots[i].state.load(std::memory_order_relaxed);
+                if (state == SLOT_EMPTY) {
+                    break;
+                }
+                if (state == SLOT_FULL &&
+                    t->slots[i].key.load(std::memory_order_relaxed) == key) {
+                    result = t->slots[i].value.load(std::memory_order_relaxed);
+                    found = true;
+                    break;
+                }
+                i = (i + 1) & t->mask;
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (shard.version.load(std::memory_order_relaxed) == v1) {
+                LeaveRead(readers);
+                if (found && value != nullptr) {
+                    *value = result;
+                }
+                return found;
+            }
+        }
+    }
+
+    // Далее — только под мьютексом шарда
+    void BeginWrite(Shard& shard) {
+        shard.version.store(
+            shard.version.load(std::memory_order_relaxed) + 1,
+            std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void EndWrite(Shard& shard) {
+        shard.version.store(
+            shard.version.load(std::memory_order_relaxed) + 1,
+            std::memory_order_release);
+    }
+
+    // Возвращает старый массив; освободить его можно только после
+    // EndWrite — через Reclaim
+    Table* Rehash(Shard& shard, std::size_t capacity) {
+        Table* old = shard.table.load(std::memory_order_relaxed);
+        Table* fresh = NewTable(capacity);
+
+        for (std::size_t i = 0; i <= old->mask; ++i) {
+            if (old->slots[i].state.load(std::memory_order_relaxed) !=
+                SLOT_FULL) {
+                continue;
+            }
+            TKey key = old->slots[i].key.load(std::memory_order_relaxed);
+            std::size_t j = HomeSlot(HashOf(key), fresh);
+            while (fresh->slots[j].state.load(std::memory_order_relaxed) !=
+                   SLOT_EMPTY) {
+                j = (j + 1) & fresh->mask;
+            }
+            fresh->slots[j].key.store(key, std::memory_order_relaxed);
+            fresh->slots[j].value.store(
+                old->slots[i].value.load(std::memory_order_relaxed),
+                std::memory_order_relaxed);
+            fresh->slots[j].state.store(SLOT_FULL, std::memory_order_relaxed);
+        }
+
+        shard.table.store(fresh, std::memory_order_seq_cst);
+        shard.deleted = 0;
+        return old;
+    }
+
+    // После EndWrite, под мьютексом шарда: читатели, которые могли взять
+    // old, вошли в текущую фазу — переключаем её и ждём их выхода.
+    // Фаза общая для всех шардов, поэтому переключения по очереди.
+    void Reclaim(Table* old) {
+        {
+            std::lock_guard<std::mutex> lock(reclaimMutex_);
+            unsigned p = phase_.load(std::memory_order_relaxed) & 1;
+            phase_.store(p ^ 1, std::memory_order_seq_cst);
+            for (const ReaderCount& stripe : readers_[p]) {
+                while (stripe.count.load(std::memory_order_seq_cst) != 0) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        DeleteTable(old);
+    }
+
+public:
+    // initialCapacity — ожидаемое число ключей на всю таблицу
+    explicit ConcurrentHashTable(
+        std::size_t initialCapacity,
+        std::function<std::size_t(const TKey&)> hashFunction,
+        std::size_t shardCount = 16)
+        : shards_(nullptr),
+          shardCount_(1),
+          shardBits_(0),
+          count_(0),
+          allocatedSlots_(0),
+          phase_(0),
+          reclaimMutex_(),
+          readers_(),
+          hashFunc_(std::move(hashFunction)) {
+
+        while (shardCount_ < shardCount) {
+            shardCount_ <<= 1;
+            ++shardBits_;
+        }
+
+        std::size_t perShard = 8;
+        while (perShard * shardCount_ < initialCapacity * 2) {
+            perShard <<= 1;
+        }
+
+        shards_ = new Shard[shardCount_];
+        for (std::size_t s = 0; s < shardCount_; ++s) {
+            shards_[s].table.store(NewTable(perShard),
+                                   std::memory_order_relaxed);
+        }
+    }
+
+    ~ConcurrentHashTable() {
+        for (std::size_t s = 0; s < shardCount_; ++s) {
+            DeleteTable(shards_[s].table.load(std::memory_order_relaxed));
+        }
+        delete[] shards_;
+    }
+
+    ConcurrentHashTable(const ConcurrentHashTable&) = delete;
+    ConcurrentHashTable& operator=(const ConcurrentHashTable&) = delete;
+
+    void Add(const TKey& key, const TValue& value) {
+        const std::uint64_t h = HashOf(key);
+        Shard& shard = ShardOf(h);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        Table* t = shard.table.load(std::memory_order_relaxed);
+
+        // Ключ уже есть — обновляем значение
+        std::size_t i = HomeSlot(h, t);
+        std::size_t freeSlot = t->mask + 1;
+        for (std::size_t probes = 0; probes <= t->mask; ++probes) {
+            std::uint8_t state = t->slots[i].state.load(std::memory_order_relaxed);
+            if (state == SLOT_EMPTY) {
+                if (freeSlot > t->mask) {
+                    freeSlot = i;
+                }
+                break;
+            }
+            if (state == SLOT_DELETED) {
+                if (freeSlot > t->mask) {
+                    freeSlot = i;
+                }
+            } else if (t->slots[i].key.load(std::memory_order_relaxed) == key) {
+                BeginWrite(shard);
+                t->slots[i].value.store(value, std::memory_order_relaxed);
+                EndWrite(shard);
+                return;
+            }
+            i = (i + 1) & t->mask;
+        }
+
+        BeginWrite(shard);
+
+        // Загрузка (с надгробиями) не выше 1/2
+        Table* old = nullptr;
+        if ((shard.count + shard.deleted + 1) * 2 > t->mask + 1) {
+            std::size_t capacity = t->mask + 1;
+            if ((shard.count + 1) * 4 > capacity) {
+                capacity *= 2;
+            }
+            old = Rehash(shard, capacity);
+            t = shard.table.load(std::memory_order_relaxed);
+            freeSlot = HomeSlot(h, t);
+            while (t->slots[freeSlot].state.load(std::memory_order_relaxed) !=
+                   SLOT_EMPTY) {
+                freeSlot = (freeSlot + 1) & t->mask;
+            }
+        }
+
+        Slot& slot = t->slots[freeSlot];
+        if (slot.state.load(std::memory_order_relaxed) == SLOT_DELETED) {
+            --shard.deleted;
+        }
+        slot.key.store(key, std::memory_order_relaxed);
+        slot.value.store(value, std::memory_order_relaxed);
+        slot.state.store(SLOT_FULL, std::memory_order_relaxed);
+        ++shard.count;
+        count_.fetch_add(1, std::memory_order_relaxed);
+
+        EndWrite(shard);
+        if (old != nullptr) {
+            Reclaim(old);
+        }
+    }
+
+    [[nodiscard]] TValue Get(const TKey& key) const {
+        TValue value{};
+        if (!ReadConsistent(key, &value)) {
+            throw std::out_of_range("Key not found");
+        }
+        return value;
+    }
+
+    [[nodiscard]] bool ContainsKey(const TKey& key) const {
+        return ReadConsistent(key, nullptr);
+    }
+
+    void Remove(const TKey& key) {
+        const std::uint64_t h = HashOf(key);
+        Shard& shard = ShardOf(h);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        Table* t = shard.table.load(std::memory_order_relaxed);
+        std::size_t i = HomeSlot(h, t);
+        for (std::size_t probes = 0; probes <= t->mask; ++probes) {
+            std::uint8_t state = t->slots[i].state.load(std::memory_order_relaxed);
+            if (state == SLOT_EMPTY) {
+                break;
+            }
+            if (state == SLOT_FULL &&
+                t->slots[i].key.load(std::memory_order_relaxed) == key) {
+                BeginWrite(shard);
+                t->slots[i].state.store(SLOT_DELETED,
+                                        std::memory_order_relaxed);
+                --shard.count;
+                ++shard.deleted;
+                count_.fetch_sub(1, std::memory_order_relaxed);
+                EndWrite(shard);
+                return;
+            }
+            i = (i + 1) & t->mask;
+        }
+        throw std::out_of_range("Key not found");
+    }
+
+    [[nodiscard]] std::size_t GetCount() const noexcept {
+        return count_.load(std::memory_order_relaxed);
+    }
+
+    // Суммарное число ячеек во всех шардах
+    [[nodiscard]] std::size_t GetCapacity() const {
+        std::size_t capacity = 0;
+        for (std::size_t s = 0; s < shardCount_; ++s) {
+            capacity +=
+                shards_[s].table.load(std::memory_order_acquire)->mask + 1;
+        }
+        return capacity;
+    }
+
+    // Ячеек во всех выделенных массивах, включая старые, ещё не
+    // освобождённые после перестройки; без читателей равно GetCapacity()
+    [[nodiscard]] std::size_t GetAllocatedSlots() const noexcept {
+        return allocatedSlots_.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] std::size_t GetShardCount() const noexcept {
+        return shardCount_;
+    }
+
+    // Снимок ключей: каждый шард читается под своим мьютексом
+    [[nodiscard]] DynamicArray<TKey> GetKeys() const {
+        DynamicArray<TKey> keys;
+        keys.reserve(GetCount());
+
+        for (std::size_t s = 0; s < shardCount_; ++s) {
+            std::lock_guard<std::mutex> lock(shards_[s].mutex);
+            const Table* t = shards_[s].table.load(std::memory_order_relaxed);
+            for (std::size_t i = 0; i <= t->mask; ++i) {
+                if (t->slots[i].state.load(std::memory_order_relaxed) ==
+                    SLOT_FULL) {
+                    keys.push_back(
+                        t->slots[i].key.load(std::memory_order_relaxed));
+                }
+            }
+        }
+        return keys;
+    }
+};
@@ -0,0 +1,355 @@
+// EvalTuner.hpp
+#pragma once
+
+#include "EvalWeights.hpp"
+#include "GameRecord.hpp"
+#include "SearchState.hpp"
+#include "DynamicArray.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+
+struct TuneSettings {
+    std::size_t threads = 0;        // 0 — по числу ядер
+    std::size_t batchSize = 4096;   // позиций в порции одного потока
+    int iterations = 300;
+    double learningRate = 2.0;      // шаг Adam, в очках оценки
+    double scale = 0.0;             // K сигмоиды; 0 — подобрать
+    // Штраф за отход от начальных весов: regularization * sum (w - w0)^2;
+    // без него на небольшой выборке веса уходят в переобучение
+    double regularization = 1e-6;
+    int logEvery = 50;              // строка в лог раз в столько итераций
+};
+
+struct TuneReport {
+    std::size_t positions = 0;
+    double scale = 0.0;
+    double initialLoss = 0.0;
+    double finalLoss = 0.0;
+};
+
+// Подбор весов оценки по линиям по записанным партиям (метод Texel).
+//
+// Позиция из партии с исходом y (1 — выиграл X, 0.5 — ничья, 0 — O)
+// должна получать оценку e (за X) с sigmoid(K * e) ≈ y; минимизируется
+// средний квадрат ошибки. Оценка без собранной линии линейна по весам:
+// e = sum counts[c] * lineScores[c] (SearchState::CountLines), поэтому
+// признаки считаются один раз, а шаг оптимизации — проход по плотному
+// массиву признаков. Позиции с собранной линией и первые skipPlies
+// ходов партии не берутся; winScore не подбирается — он влияет только
+// на выигранные позиции. Признаки сильно коррелированы (линия из трёх
+// камней — три признака count = 3), поэтому к ошибке добавляется штраф
+// за отход от начальных весов.
+//
+// Проходы устроены как map-reduce без общих данных: позиции разбиты на
+// порции по batchSize, поток берёт порции t, t + T, ... и пишет сумму
+// ошибки и градиента порции в её собственную ячейку; ячейки суммируются
+// по порядку. Результат не зависит от числа потоков.
+class EvalTuner {
+private:
+    int winLength_;
+    int featureCount_;                       // 2 * winLength: count < 2W
+    DynamicArray<std::int32_t> features_;    // [позиция][featureCount_]
+    DynamicArray<float> results_;
+
+    // Сумма ошибки и градиента по порции позиций
+    struct Partial {
+        double loss = 0.0;
+        double gradient[EvalWeights::kMaxLineCount] = {};
+    };
+
+    [[nodiscard]] static std::size_t ThreadCount(std::size_t threads) {
+        if (threads == 0) {
+            threads = std::thread::hardware_concurrency();
+        }
+        return threads == 0 ? 1 : threads;
+    }
+
+    // Позиции одной партии: признаки дописываются в features, исходы —
+    // в results
+    void ExtractGame(const GameRecordView& game, int skipPlies,
+                     SearchState& state, DynamicArray<std::int32_t>& features,
+                     DynamicArray<float>& results) const {
+        const Cell winner = game.GetWinner();
+        const float result = winner == X ? 1.0f : winner == O ? 0.0f : 0.5f;
+        int counts[EvalWeights::kMaxLineCount];
+
+        state.Load(DynamicArray<Stone>(), winLength_, 1);
+        int ply = 0;
+        bool over = false;
+        game.ForEachMove([&](const Position& move, Cell player) {
+            if (over) {
+                return;
+            }
+            if (!IsValidCoord(move.x, move.y) ||
+                state.At(move.x, move.y) != EMPTY) {
+                over = true;
+                return;
+            }
+            state.MakeMove(move, player);
+            ++ply;
+            if (state.CheckWinAt(move, player)) {
+                over = true;
+                return;
+            }
+            if (ply > skipPlies) {
+                state.CountLines(X, counts, featureCount_);
+                for (int c = 0; c < featureCount_; ++c) {
+                    features.push_back(counts[c]);
+                }
+                results.push_back(result);
+            }
+        });
+    }
+
+    // Проход по всем позициям: ошибка и (если gradient) градиент по
+    // lineScores при весах w
+    Partial Pass(const double* w, double scale, bool gradient,
+                 const TuneSettings& settings) const {
+        const std::size_t positions = results_.size();
+        const std::size_t batch = settings.batchSize > 0 ? settings.batchSize
+                                                         : 4096;
+        const std::size_t batches = (positions + batch - 1) / batch;
+        const std::size_t threads =
+            std::min(ThreadCount(settings.threads), std::max<std::size_t>(
+                batches, 1));
+        const int featureCount = featureCount_;
+
+        DynamicArray<Partial> partials(batches);
+        for (std::size_t i = 0; i < batches; ++i) {
+            partials.push_back(Partial());
+        }
+
+        auto work = [&](std::size_t thread) {
+            for (std::size_t b = thread; b < batches; b += threads) {
+                Partial& part = partials[b];
+                const std::size_t end = std::min(positions, (b + 1) * batch);
+                for (std::size_t i = b * batch; i < end; ++i) {
+                    const std::int32_t* f =
+                        features_.begin() + i * featureCount;
+                    double e = 0.0;
+                    for (int c = 0; c < featureCount; ++c) {
+                        e += f[c] * w[c];
+                    }
+                    double s = 1.0 / (1.0 + std::exp(-scale * e));
+                    double error = s - results_.begin()[i];
+                    part.loss += error * error;
+                    if (gradient) {
+                        double g = 2.0 * error * s * (1.0 - s) * scale;
+                        for (int c = 0; c < featureCount; ++c) {
+                            part.gradient[c] += g * f[c];
+                        }
+                    }
+                }
+            }
+        };
+
+        DynamicArray<std::thread> helpers;
+        for (std::size_t t = 1; t < threads; ++t) {
+            helpers.push_back(std::thread(work, t));
+        }
+        work(0);
+        for (auto& helper : helpers) {
+            helper.join();
+        }
+
+        Partial total;
+        for (const auto& part : partials) {
+            total.loss += part.loss;
+            for (int c = 0; c < featureCount; ++c) {
+                total.gradient[c] += part.gradient[c];
+            }
+        }
+        if (positions > 0) {
+            total.loss /= static_cast<double>(positions);
+            for (int c = 0; c < featureCount; ++c) {
+                total.gradient[c] /= static_cast<double>(positions);
+            }
+        }
+        return total;
+    }
+
+    void ToArray(const EvalWeights& weights, double* w) const {
+        for (int c = 0; c < featureCount_; ++c) {
+            w[c] = weights.lineScores[c];
+        }
+    }
+
+public:
+    explicit EvalTuner(int winLength = 5)
+        : winLength_(winLength),
+          featureCount_(2 * winLength),
+          features_(),
+          results_() {
+        if (winLength < 1 || 2 * winLength > EvalWeights::kMaxLineCount) {
+            throw std::invalid_argument("unsupported tuner win length");
+        }
+    }
+
+    // Позиции всех партий файла с той же длиной линии; партии делятся
+    // между потоками непрерывными кусками, порядок позиций — как в
+    // файле. Возвращает число добавленных позиций.
+    std::size_t AddGames(const GameRecordReader& reader, int skipPlies = 4,
+                         std::size_t threads = 0) {
+        const std::size_t games = reader.GetGameCount();
+        threads = std::min(ThreadCount(threads),
+                           std::max<std::size_t>(games, 1));
+
+        struct Chunk {
+            DynamicArray<std::int32_t> features;
+            DynamicArray<float> results;
+        };
+        DynamicArray<Chunk> chunks(threads);
+        for (std::size_t t = 0; t < threads; ++t) {
+            chunks.push_back(Chunk());
+        }
+
+        auto work = [&](std::size_t thread) {
+            SearchState state;
+            Chunk& chunk = chunks[thread];
+            const std::size_t begin = games * thread / threads;
+            const std::size_t end = games * (thread + 1) / threads;
+            for (std::size_t g = begin; g < end; ++g) {
+                GameRecordView game = reader.GetGame(g);
+                if (game.GetWinLength() == winLength_) {
+                    ExtractGame(game, skipPlies, state, chunk.features,
+                                chunk.results);
+                }
+            }
+        };
+
+        DynamicArray<std::thread> helpers;
+        for (std::size_t t = 1; t < threads; ++t) {
+            helpers.push_back(std::thread(work, t));
+        }
+        work(0);
+        for (auto& helper : helpers) {
+            helper.join();
+        }
+
+        std::size_t added = 0;
+        for (const auto& chunk : chunks) {
+            features_.reserve(features_.size() + chunk.features.size());
+            for (std::int32_t f : chunk.features) {
+                features_.push_back(f);
+            }
+            for (float r : chunk.results) {
+                results_.push_back(r);
+            }
+            added += chunk.results.size();
+        }
+        return added;
+    }
+
+    [[nodiscard]] std::size_t GetPositionCount() const noexcept {
+        return results_.size();
+    }
+
+    [[nodiscard]] int GetWinLength() const noexcept {
+        return winLength_;
+    }
+
+    // Средний квадрат ошибки при весах weights и коэффициенте scale
+    [[nodiscard]] double Loss(const EvalWeights& weights, double scale,
+                              std::size_t threads = 0) const {
+        double w[EvalWeights::kMaxLineCount];
+        ToArray(weights, w);
+        TuneSettings settings;
+        settings.threads = threads;
+        return Pass(w, scale, false, settings).loss;
+    }
+
+    // K, при котором начальные веса лучше всего предсказывают исходы:
+    // тернарный поиск по log K
+    [[nodiscard]] double FitScale(const EvalWeights& weights,
+                                  std::size_t threads = 0) const {
+        double lo = std::log(1e-6);
+        double hi = std::log(1e-1);
+        for (int i = 0; i < 40; ++i) {
+            double a = lo + (hi - lo) / 3.0;
+            double b = hi - (hi - lo) / 3.0;
+            if (Loss(weights, std::exp(a), threads) <
+                Loss(weights, std::exp(b), threads)) {
+                hi = b;
+            } else {
+                lo = a;
+            }
+        }
+        return std::exp((lo + hi) / 2.0);
+    }
+
+    // Подбирает lineScores[1 .. 2 * winLength - 1] (Adam по полному
+    // градиенту), начиная с weights; результат округляется до целых.
+    // log — куда печатать ход подбора (nullptr — никуда).
+    TuneReport Tune(EvalWeights& weights, const TuneSettings& settings,
+                    std::ostream* log = nullptr) const {
+        TuneReport report;
+        report.positions = results_.size();
+        if (results_.empty()) {
+            return report;
+        }
+
+        const double scale = settings.scale > 0.0
+                                 ? settings.scale
+                                 : FitScale(weights, settings.threads);
+        report.scale = scale;
+
+        double w[EvalWeights::kMaxLineCount];
+        double start[EvalWeights::kMaxLineCount];
+        double m[EvalWeights::kMaxLineCount] = {};
+        double v[EvalWeights::kMaxLineCount] = {};
+        ToArray(weights, w);
+        ToArray(weights, start);
+
+        const double beta1 = 0.9;
+        const double beta2 = 0.999;
+        double beta1Power = 1.0;
+        double beta2Power = 1.0;
+        for (int it = 0; it < settings.iterations; ++it) {
+            Partial pass = Pass(w, scale, true, settings);
+            for (int c = 1; c < featureCount_; ++c) {
+                double delta = w[c] - start[c];
+                pass.loss += settings.regularization * delta * delta;
+                pass.gradient[c] += 2.0 * settings.regularization * delta;
+            }
+            if (it == 0) {
+                report.initialLoss = pass.loss;
+            }
+            if (log != nullptr && settings.logEvery > 0 &&
+                it % settings.logEvery == 0) {
+                *log << "итерация " << it << ": ошибка " << pass.loss << "\n";
+            }
+
+            beta1Power *= beta1;
+            beta2Power *= beta2;
+            // count = 0 в линиях не бывает
+            for (int c = 1; c < featureCount_; ++c) {
+                double g = pass.gradient[c];
+                m[c] = beta1 * m[c] + (1.0 - beta1) * g;
+                v[c] = beta2 * v[c] + (1.0 - beta2) * g * g;
+                double mHat = m[c] / (1.0 - beta1Power);
+                double vHat = v[c] / (1.0 - beta2Power);
+                w[c] -= settings.learningRate * mHat / (std::sqrt(vHat) + 1e-12);
+            }
+        }
+
+        for (int c = 1; c < featureCount_; ++c) {
+            weights.lineScores[c] = static_cast<int>(std::lround(w[c]));
+        }
+        report.finalLoss = Loss(weights, scale, settings.threads);
+        if (settings.iterations == 0) {
+            report.initialLoss = report.finalLoss;
+        }
+        if (log != nullptr) {
+            *log << "позиций " << report.positions << ", K " << scale
+                 << ", ошибка " << report.initialLoss << " -> "
+                 << report.finalLoss << "\n";
+        }
+        return report;
+    }
+};
@@ -0,0 +1,117 @@
+// EvalWeights.hpp
+#pragma once
+
+#include <cstddef>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+// Веса оценки по линиям (SearchState::EvaluateFixed): очки за собранную
+// линию и за линию из count своих камней. По умолчанию — прежние
+// константы: 10000 и count * count * 10.
+//
+// Текстовый файл весов (его пишет tune.cpp):
+//
+//   # комментарий
+//   win 10000
+//   line 0 10 40 90 160 ...
+//
+// line — очки для count = 0, 1, 2, ... подряд; не указанные значения
+// остаются по умолчанию. Порядок строк любой, каждая необязательна.
+struct EvalWeights {
+    // count не больше 2 * winLength - 1; для более длинных линий берётся
+    // последнее значение
+    static constexpr int kMaxLineCount = 64;
+
+    int winScore = 10000;
+    int lineScores[kMaxLineCount];
+
+    EvalWeights() : lineScores() {
+        for (int i = 0; i < kMaxLineCount; ++i) {
+            lineScores[i] = i * i * 10;
+        }
+    }
+
+    [[nodiscard]] int LineScore(int count) const noexcept {
+        return lineScores[count < kMaxLineCount ? count : kMaxLineCount - 1];
+    }
+
+    bool operator==(const EvalWeights& other) const noexcept {
+        if (winScore != other.winScore) {
+            return false;
+        }
+        for (int i = 0; i < kMaxLineCount; ++i) {
+            if (lineScores[i] != other.lineScores[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool operator!=(const EvalWeights& other) const noexcept {
+        return !(*this == other);
+    }
+
+    // lineCount — сколько значений line записать (обычно 2 * winLength)
+    bool Save(const std::string& path, int lineCount = kMaxLineCount) const {
+        std::ofstream out(path, std::ios::trunc);
+        if (!out.is_open()) {
+            return false;
+        }
+        if (lineCount > kMaxLineCount) {
+            lineCount = kMaxLineCount;
+        }
+        out << "# веса оценки по линиям (EvalWeights.hpp)\n";
+        out << "win " << winScore << "\n";
+        out << "line";
+        for (int i = 0; i < lineCount; ++i) {
+            out << ' ' << lineScores[i];
+        }
+        out << "\n";
+        return static_cast<bool>(out);
+    }
+
+    // false — файл не открылся или в нём ошибка; веса тогда не меняются
+    bool Load(const std::string& path) {
+        std::ifstream in(path);
+        if (!in.is_open()) {
+            return false;
+        }
+
+        EvalWeights loaded = *this;
+        std::string text;
+        while (std::getline(in, text)) {
+            std::istringstream line(text);
+            std::string key;
+            if (!(line >> key) || key[0] == '#') {
+                continue;
+            }
+            if (key == "win") {
+                if (!(line >> loaded.winScore) || loaded.winScore <= 0) {
+                    return false;
+                }
+            } else if (key == "line") {
+                int count = 0;
+                int value = 0;
+                while (line >> value) {
+                    if (count == kMaxLineCount) {
+                        return false;
+                    }
+                    loaded.lineScores[count++] = value;
+                }
+                if (!line.eof()) {
+                    return false;
+                }
+            } else {
+                return false;
+            }
+            std::string rest;
+            if (line >> rest) {
+                return false;
+            }
+        }
+
+        *this = loaded;
+        return true;
+    }
+};
@@ -0,0 +1,470 @@
+// GameRecord.hpp
+#pragma once
+
+#include "TicTacToe.hpp"
+#include "DynamicArray.hpp"
+#include "MappedFile.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <system_error>
+
+// Формат файла партий (little-endian, как в памяти):
+//
+//   GameFileHeader                        — 16 байт
+//   партия, партия, ...                   — дописываются в конец
+//   std::uint64_t offsets[gameCount]      — индекс: смещения партий
+//   GameIndexFooter                       — 24 байта
+//
+// Партия — GameRecordHeader (4 байта) и 2 * plies чисел varint (LEB128)
+// в zigzag-кодировке: первый ход — координаты как есть, дальше — разность
+// с предыдущим ходом. Ходы чередуются, первым ходит X. Соседние ходы
+// обычно рядом, так что ход занимает 2–4 байта.
+//
+// Индекс пишется при закрытии писателя. Если его нет (процесс упал),
+// читатель находит партии последовательным проходом, а писатель при
+// открытии отрезает недописанную последнюю партию.
+
+struct GameFileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t reserved;
+};
+
+struct GameRecordHeader {
+    std::uint16_t plies;
+    std::uint8_t winLength;
+    std::uint8_t winner;        // Cell: EMPTY — ничья или партия прервана
+};
+
+struct GameIndexFooter {
+    std::uint64_t gameCount;
+    std::uint64_t indexOffset;
+    char magic[8];
+};
+
+static_assert(sizeof(GameFileHeader) == 16, "unexpected game file header size");
+static_assert(sizeof(GameRecordHeader) == 4, "unexpected game header size");
+static_assert(sizeof(GameIndexFooter) == 24, "unexpected game index size");
+
+namespace record_detail {
+
+constexpr char kMagic[8] = { 'T', 'T', 'T', 'G', 'A', 'M', 'E', '1' };
+constexpr char kIndexMagic[8] = { 'T', 'T', 'T', 'I', 'N', 'D', 'X', '1' };
+constexpr std::uint32_t kVersion = 1;
+
+inline std::uint32_t ZigZag(std::int32_t v) noexcept {
+    return (static_cast<std::uint32_t>(v) << 1) ^
+           static_cast<std::uint32_t>(v >> 31);
+}
+
+inline std::int32_t UnZigZag(std::uint32_t v) noexcept {
+    return static_cast<std::int32_t>(v >> 1) ^
+           -static_cast<std::int32_t>(v & 1);
+}
+
+inline void PutVarint(std::string& out, std::uint32_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<char>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<char>(v));
+}
+
+// nullptr — число не уместилось до end
+inline const unsigned char* GetVarint(const unsigned char* p,
+                                      const unsigned char* end,
+                                      std::uint32_t& v) noexcept {
+    v = 0;
+    for (int shift = 0; shift < 35 && p < end; shift += 7) {
+        unsigned char byte = *p++;
+        v |= static_cast<std::uint32_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return p;
+        }
+    }
+    return nullptr;
+}
+
+// Конец партии, начинающейся в p, или nullptr, если партия повреждена
+// или обрезана. Заголовок и ходы проверяются: после сбоя посреди Close
+// за партиями может лежать недописанный индекс, и он не должен сойти
+// за партию.
+inline const unsigned char* SkipGame(const unsigned char* p,
+                                     const unsigned char* end) noexcept {
+    if (end - p < static_cast<std::ptrdiff_t>(sizeof(GameRecordHeader))) {
+        return nullptr;
+    }
+    GameRecordHeader header;
+    std::memcpy(&header, p, sizeof(header));
+    if (header.winLength == 0 ||
+        (header.winner != EMPTY && header.winner != X &&
+         header.winner != O)) {
+        return nullptr;
+    }
+    p += sizeof(header);
+
+    // Сложение по модулю 2^32: у мусорной разности сумма, вышедшая
+    // за int, даёт координату далеко за kMaxCoord, а не переполнение
+    std::uint32_t x = 0;
+    std::uint32_t y = 0;
+    for (std::uint32_t i = 0; i < header.plies; ++i) {
+        std::uint32_t dx = 0, dy = 0;
+        p = GetVarint(p, end, dx);
+        if (p == nullptr) {
+            return nullptr;
+        }
+        p = GetVarint(p, end, dy);
+        if (p == nullptr) {
+            return nullptr;
+        }
+        x += static_cast<std::uint32_t>(UnZigZag(dx));
+        y += static_cast<std::uint32_t>(UnZigZag(dy));
+        if (!IsValidCoord(static_cast<int>(x), static_cast<int>(y))) {
+            return nullptr;
+        }
+    }
+    return p;
+}
+
+// Смещения партий файла. Сначала индекс; если его нет — проход по
+// партиям. dataEnd — конец последней целой партии.
+inline bool ScanGames(const unsigned char* data, std::size_t size,
+                      DynamicArray<std::uint64_t>& offsets,
+                      std::uint64_t& dataEnd) {
+    offsets.clear();
+    if (size < sizeof(GameFileHeader) ||
+        std::memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+        return false;
+    }
+    GameFileHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.version != kVersion) {
+        return false;
+    }
+
+    if (size >= sizeof(GameFileHeader) + sizeof(GameIndexFooter)) {
+        GameIndexFooter footer;
+        std::memcpy(&footer, data + size - sizeof(footer), sizeof(footer));
+        if (std::memcmp(footer.magic, kIndexMagic, sizeof(kIndexMagic)) == 0) {
+            // Подвал пишется последним: если он на месте, но не сходится
+            // с размером, файл испорчен, а не оборван сбоем. Только
+            // вычитания: поля подвала из файла, сумма с ними может
+            // переполниться и сойтись с размером.
+            const std::uint64_t footerStart = size - sizeof(footer);
+            if (footer.indexOffset < sizeof(GameFileHeader) ||
+                footer.indexOffset > footerStart ||
+                (footerStart - footer.indexOffset) % sizeof(std::uint64_t) != 0 ||
+                footer.gameCount != (footerStart - footer.indexOffset) /
+                                        sizeof(std::uint64_t)) {
+                return false;
+            }
+            offsets.reserve(static_cast<std::size_t>(footer.gameCount));
+            const unsigned char* index = data + footer.indexOffset;
+            for (std::uint64_t i = 0; i < footer.gameCount; ++i) {
+                std::uint64_t offset = 0;
+                std::memcpy(&offset, index + i * sizeof(offset),
+                            sizeof(offset));
+                if (offset < sizeof(GameFileHeader) ||
+                    offset > footer.indexOffset - sizeof(GameRecordHeader)) {
+                    offsets.clear();
+                    return false;
+                }
+                offsets.push_back(offset);
+            }
+            dataEnd = footer.indexOffset;
+            return true;
+        }
+    }
+
+    const unsigned char* end = data + size;
+    const unsigned char* p = data + sizeof(GameFileHeader);
+    while (p < end) {
+        const unsigned char* next = SkipGame(p, end);
+        if (next == nullptr) {
+            break;
+        }
+        offsets.push_back(static_cast<std::uint64_t>(p - data));
+        p = next;
+    }
+    dataEnd = static_cast<std::uint64_t>(p - data);
+    return true;
+}
+
+} // namespace record_detail
+
+// Запись партий: файл только дописывается. Если файл уже есть, новые
+// партии идут после старых, а индекс при закрытии пишется заново.
+// Append можно вызывать из нескольких потоков.
+class GameRecordWriter {
+private:
+    std::ofstream out_;
+    std::string path_;
+    DynamicArray<std::uint64_t> offsets_;
+    std::uint64_t position_;
+    std::string buffer_;
+    std::mutex mutex_;
+
+public:
+    GameRecordWriter() : position_(0) {}
+
+    ~GameRecordWriter() {
+        Close();
+    }
+
+    GameRecordWriter(const GameRecordWriter&) = delete;
+    GameRecordWriter& operator=(const GameRecordWriter&) = delete;
+
+    bool Open(const std::string& path) {
+        Close();
+
+        std::error_code error;
+        std::uintmax_t size = std::filesystem::file_size(path, error);
+        if (!error && size > 0) {
+            // Старый индекс (или недописанный хвост) отрезается и
+            // переписывается при закрытии
+            std::uint64_t dataEnd = 0;
+            {
+                MappedFile file;
+                if (!file.Open(path) ||
+                    !record_detail::ScanGames(file.Data(), file.Size(),
+                                              offsets_, dataEnd)) {
+                    return false;
+                }
+            }
+            std::filesystem::resize_file(path, dataEnd, error);
+            if (error) {
+                offsets_.clear();
+                return false;
+            }
+            out_.open(path, std::ios::binary | std::ios::app);
+            position_ = dataEnd;
+        } else {
+            out_.open(path, std::ios::binary | std::ios::trunc);
+            GameFileHeader header{};
+            std::memcpy(header.magic, record_detail::kMagic,
+                        sizeof(record_detail::kMagic));
+            header.version = record_detail::kVersion;
+            out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            position_ = sizeof(header);
+        }
+
+        if (!out_) {
+            out_.close();
+            offsets_.clear();
+            return false;
+        }
+        path_ = path;
+        return true;
+    }
+
+    // Пишет индекс и закрывает файл
+    bool Close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!out_.is_open()) {
+            return true;
+        }
+
+        if (!offsets_.empty()) {
+            out_.write(reinterpret_cast<const char*>(offsets_.begin()),
+                       static_cast<std::streamsize>(
+                           offsets_.size() * sizeof(std::uint64_t)));
+        }
+        GameIndexFooter footer{};
+        footer.gameCount = offsets_.size();
+        footer.indexOffset = position_;
+        std::memcpy(footer.magic, record_detail::kIndexMagic,
+                    sizeof(record_detail::kIndexMagic));
+        out_.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+
+        bool ok = static_cast<bool>(out_);
+        out_.close();
+        offsets_.clear();
+        path_.clear();
+        position_ = 0;
+        return ok;
+    }
+
+    [[nodiscard]] bool IsOpen() const noexcept {
+        return out_.is_open();
+    }
+
+    // Всего партий в файле, включая записанные до Open
+    [[nodiscard]] std::size_t GetGameCount() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return offsets_.size();
+    }
+
+    // moves — ходы по порядку, первым X; winner — EMPTY для ничьей
+    bool Append(const DynamicArray<Position>& moves, int winLength,
+                Cell winner) {
+        if (moves.size() > 0xffff || winLength <= 0 || winLength > 0xff) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!out_.is_open()) {
+            return false;
+        }
+
+        GameRecordHeader header;
+        header.plies = static_cast<std::uint16_t>(moves.size());
+        header.winLength = static_cast<std::uint8_t>(winLength);
+        header.winner = static_cast<std::uint8_t>(winner);
+
+        buffer_.assign(reinterpret_cast<const char*>(&header), sizeof(header));
+        Position previous(0, 0);
+        for (const auto& m : moves) {
+            record_detail::PutVarint(buffer_,
+                                     record_detail::ZigZag(m.x - previous.x));
+            record_detail::PutVarint(buffer_,
+                                     record_detail::ZigZag(m.y - previous.y));
+            previous = m;
+        }
+
+        out_.write(buffer_.data(),
+                   static_cast<std::streamsize>(buffer_.size()));
+        if (!out_) {
+            return false;
+        }
+        offsets_.push_back(position_);
+        position_ += buffer_.size();
+        return true;
+    }
+};
+
+// Партия внутри отображённого файла; ходы декодируются на лету
+class GameRecordView {
+private:
+    const unsigned char* moves_;
+    const unsigned char* end_;
+    GameRecordHeader header_;
+
+public:
+    GameRecordView(const unsigned char* game, const unsigned char* end)
+        : moves_(game + sizeof(GameRecordHeader)), end_(end), header_() {
+        std::memcpy(&header_, game, sizeof(header_));
+    }
+
+    [[nodiscard]] std::size_t GetPlies() const noexcept {
+        return header_.plies;
+    }
+
+    [[nodiscard]] int GetWinLength() const noexcept {
+        return header_.winLength;
+    }
+
+    [[nodiscard]] Cell GetWinner() const noexcept {
+        return static_cast<Cell>(header_.winner);
+    }
+
+    // func(const Position& move, Cell player) для каждого хода по порядку;
+    // false — партия повреждена
+    template<typename Func>
+    bool ForEachMove(Func&& func) const {
+        const unsigned char* p = moves_;
+        // Сумма по модулю 2^32, как в SkipGame: партии из индекса им не
+        // проверялись, и испорченная разность не должна переполнить int
+        std::uint32_t x = 0;
+        std::uint32_t y = 0;
+        Cell player = X;
+        for (std::size_t i = 0; i < header_.plies; ++i) {
+            std::uint32_t dx = 0, dy = 0;
+            p = record_detail::GetVarint(p, end_, dx);
+            if (p == nullptr) {
+                return false;
+            }
+            p = record_detail::GetVarint(p, end_, dy);
+            if (p == nullptr) {
+                return false;
+            }
+            x += static_cast<std::uint32_t>(record_detail::UnZigZag(dx));
+            y += static_cast<std::uint32_t>(record_detail::UnZigZag(dy));
+            const Position move(static_cast<int>(x), static_cast<int>(y));
+            if (!IsValidCoord(move.x, move.y)) {
+                return false;
+            }
+            func(move, player);
+            player = (player == X) ? O : X;
+        }
+        return true;
+    }
+
+    bool GetMoves(DynamicArray<Position>& moves) const {
+        moves.clear();
+        moves.reserve(header_.plies);
+        return ForEachMove([&moves](const Position& m, Cell) {
+            moves.push_back(m);
+        });
+    }
+};
+
+// Чтение партий: файл отображается в память, партии доступны по номеру
+// без чтения и разбора всего файла
+class GameRecordReader {
+private:
+    MappedFile file_;
+    DynamicArray<std::uint64_t> offsets_;
+    std::uint64_t dataEnd_;
+
+public:
+    GameRecordReader() : dataEnd_(0) {}
+
+    bool Open(const std::string& path) {
+        Close();
+        if (!file_.Open(path) ||
+            !record_detail::ScanGames(file_.Data(), file_.Size(), offsets_,
+                                      dataEnd_)) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void Close() {
+        file_.Close();
+        offsets_.clear();
+        dataEnd_ = 0;
+    }
+
+    [[nodiscard]] bool IsOpen() const noexcept {
+        return file_.IsOpen();
+    }
+
+    [[nodiscard]] std::size_t GetGameCount() const noexcept {
+        return offsets_.size();
+    }
+
+    [[nodiscard]] GameRecordView GetGame(std::size_t index) const {
+        return GameRecordView(file_.Data() + offsets_[index],
+                              file_.Data() + dataEnd_);
+    }
+
+    // Расставляет на game первые plies ходов партии (все, если plies
+    // больше длины партии); game сбрасывается, но сохраняет таблицу
+    // транспозиций и настройки. Длина ряда game должна совпадать с
+    // записанной. Возвращает, чей теперь ход, или EMPTY, если партия
+    // повреждена или ход незаконен.
+    template<int WinLength>
+    Cell Replay(std::size_t index, BasicTicTacToeGame<WinLength>& game,
+                std::size_t plies = static_cast<std::size_t>(-1)) const {
+        GameRecordView view = GetGame(index);
+        game.Reset();
+        std::size_t played = 0;
+        bool legal = true;
+        bool intact = view.ForEachMove([&](const Position& m, Cell player) {
+            if (played < plies) {
+                legal = legal && game.MakeMove(m.x, m.y, player);
+                ++played;
+            }
+        });
+        if (!intact || !legal) {
+            return EMPTY;
+        }
+        return (played % 2 == 0) ? X : O;
+    }
+};
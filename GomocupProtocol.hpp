@@ -0,0 +1,321 @@
+// GomocupProtocol.hpp
+#pragma once
+
+#include "TicTacToe.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+// Движок для турнирных оболочек (piskvork, Gomocup): текстовый протокол
+// «команда — ответ» через потоки ввода-вывода. Поддерживаются START,
+// RECTSTART, RESTART, BEGIN, TURN, BOARD, TAKEBACK, INFO, ABOUT и END.
+//
+// Процесс живёт весь матч: партия и таблица транспозиций переживают
+// ходы и партии (RESTART/START очищают только доску). Наши камни — X,
+// камни соперника — O; координаты — клетки доски, (0, 0) — угол.
+// Победа — пять и больше в ряд (свободный гомоку).
+//
+// Если задан файл весов оценки (EvalWeights.hpp), он перечитывается
+// перед каждой партией (START, RECTSTART, RESTART), когда изменился:
+// новые веса из tune подхватываются без перезапуска движка.
+class GomocupEngine {
+private:
+    TicTacToeGame game_;
+    int width_;
+    int height_;
+    bool started_;
+
+    // Настройки из INFO, в миллисекундах и байтах (0 — не задано)
+    long long timeoutTurnMs_;
+    long long timeLeftMs_;          // -1 — оболочка не сообщала
+    long long maxMemory_;
+
+    std::string weightsPath_;       // пусто — веса по умолчанию
+    std::filesystem::file_time_type weightsTime_;
+    bool weightsLoaded_;
+
+    static constexpr int kWinLength = 5;
+    static constexpr long long kDefaultTurnMs = 5000;
+    // Запас на разбор команды, вывод и задержки оболочки
+    static constexpr long long kSafetyMarginMs = 30;
+    // На сколько ходов вперёд делить оставшееся время матча
+    static constexpr long long kMovesToGo = 20;
+
+    static void Reply(std::ostream& out, const std::string& text) {
+        out << text << '\n';
+        out.flush();
+    }
+
+    static std::string Trim(const std::string& text) {
+        std::size_t begin = 0;
+        std::size_t end = text.size();
+        while (begin < end &&
+               std::isspace(static_cast<unsigned char>(text[begin]))) {
+            ++begin;
+        }
+        while (end > begin &&
+               std::isspace(static_cast<unsigned char>(text[end - 1]))) {
+            --end;
+        }
+        return text.substr(begin, end - begin);
+    }
+
+    // "x,y" или "x,y,поле"; field = 0, если поля нет
+    static bool ParseXY(const std::string& text, int& x, int& y,
+                        int* field = nullptr) {
+        std::istringstream in(text);
+        char comma = 0;
+        if (!(in >> x >> comma) || comma != ',' || !(in >> y)) {
+            return false;
+        }
+        if (field != nullptr) {
+            *field = 0;
+            if (in >> comma) {
+                if (comma != ',' || !(in >> *field)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Нет файла или он с ошибкой — остаются прежние веса
+    void ReloadWeights() {
+        if (weightsPath_.empty()) {
+            return;
+        }
+        std::error_code error;
+        auto time = std::filesystem::last_write_time(weightsPath_, error);
+        if (error || (weightsLoaded_ && time == weightsTime_)) {
+            return;
+        }
+        EvalWeights weights;
+        if (weights.Load(weightsPath_)) {
+            game_.SetEvalWeights(weights);
+            weightsTime_ = time;
+            weightsLoaded_ = true;
+        }
+    }
+
+    bool Start(int width, int height, std::ostream& out) {
+        if (width < kWinLength || height < kWinLength ||
+            width - 1 > kMaxCoord || height - 1 > kMaxCoord) {
+            Reply(out, "ERROR unsupported board size");
+            return false;
+        }
+        width_ = width;
+        height_ = height;
+        started_ = true;
+
+        BoardBounds bounds;
+        bounds.minX = 0;
+        bounds.minY = 0;
+        bounds.maxX = width - 1;
+        bounds.maxY = height - 1;
+        game_.Reset();
+        game_.SetBoardBounds(bounds);
+        ReloadWeights();
+        Reply(out, "OK");
+        return true;
+    }
+
+    // Бюджет хода: лимит на ход, но не больше доли оставшегося времени
+    // матча, минус запас
+    [[nodiscard]] std::chrono::milliseconds MoveBudget() const {
+        long long budget = timeoutTurnMs_ > 0 ? timeoutTurnMs_ : 0;
+        if (timeLeftMs_ >= 0) {
+            budget = std::min(budget, timeLeftMs_ / kMovesToGo);
+        }
+        budget = std::max(budget - kSafetyMarginMs, 1LL);
+        return std::chrono::milliseconds(budget);
+    }
+
+    void Think(std::ostream& out) {
+        Position move = game_.FindBestMoveTimed(X, MoveBudget());
+        if (!game_.MakeMove(move.x, move.y, X)) {
+            Reply(out, "ERROR no legal move");
+            return;
+        }
+        Reply(out, std::to_string(move.x) + "," + std::to_string(move.y));
+    }
+
+    void Info(const std::string& args) {
+        std::istringstream in(args);
+        std::string key;
+        long long value = 0;
+        if (!(in >> key >> value)) {
+            return;     // нечисловые ключи (folder, evaluate) не нужны
+        }
+        if (key == "timeout_turn") {
+            timeoutTurnMs_ = value;
+        } else if (key == "time_left") {
+            timeLeftMs_ = value;
+        } else if (key == "max_memory" && value != maxMemory_) {
+            maxMemory_ = value;
+            // Половина памяти — таблице транспозиций; Resize округляет
+            // вверх, поэтому берём степень двойки не больше лимита
+            if (value > 0) {
+                std::size_t limit = static_cast<std::size_t>(value) / 2 /
+                                    sizeof(TranspositionTable::Entry);
+                std::size_t entries = 1;
+                while (entries * 2 <= limit) {
+                    entries *= 2;
+                }
+                game_.SetTranspositionTableSize(limit == 0 ? 0 : entries);
+            }
+        }
+    }
+
+    // BOARD: строки "x,y,поле" до DONE; поле 1 — наш камень, 2 — соперника
+    void Board(std::istream& in, std::ostream& out) {
+        game_.Reset();
+        bool ok = true;
+        std::string line;
+        while (std::getline(in, line)) {
+            line = Trim(line);
+            if (line == "DONE") {
+                break;
+            }
+            int x = 0, y = 0, field = 0;
+            if (!ParseXY(line, x, y, &field) ||
+                !game_.MakeMove(x, y, field == 1 ? X : O)) {
+                ok = false;
+            }
+        }
+        if (!ok) {
+            Reply(out, "ERROR invalid board");
+            return;
+        }
+        Think(out);
+    }
+
+public:
+    explicit GomocupEngine(const std::string& weightsPath = "")
+        : game_(kWinLength),
+          width_(0),
+          height_(0),
+          started_(false),
+          timeoutTurnMs_(kDefaultTurnMs),
+          timeLeftMs_(-1),
+          maxMemory_(0),
+          weightsPath_(weightsPath),
+          weightsTime_(),
+          weightsLoaded_(false) {}
+
+    [[nodiscard]] const EvalWeights& GetEvalWeights() const noexcept {
+        return game_.GetEvalWeights();
+    }
+
+    // Обрабатывает команды до END или конца ввода
+    void Run(std::istream& in, std::ostream& out) {
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!HandleCommand(line, in, out)) {
+                break;
+            }
+        }
+    }
+
+    // Одна команда (BOARD дочитывает свои строки из in); false — END
+    bool HandleCommand(const std::string& rawLine, std::istream& in,
+                       std::ostream& out) {
+        std::string line = Trim(rawLine);
+        if (line.empty()) {
+            return true;
+        }
+
+        std::size_t space = line.find(' ');
+        std::string command = line.substr(0, space);
+        std::string args =
+            space == std::string::npos ? "" : Trim(line.substr(space + 1));
+        for (char& c : command) {
+            c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+        }
+
+        if (command == "END") {
+            return false;
+        }
+        if (command == "INFO") {
+            Info(args);
+            return true;
+        }
+        if (command == "ABOUT") {
+            Reply(out, "name=\"laba2\", version=\"1.0\"");
+            return true;
+        }
+        if (command == "START") {
+            int size = 0;
+            std::istringstream sizeIn(args);
+            if (!(sizeIn >> size)) {
+                Reply(out, "ERROR expected board size");
+                return true;
+            }
+            Start(size, size, out);
+            return true;
+        }
+        if (command == "RECTSTART") {
+            int width = 0, height = 0;
+            if (!ParseXY(args, width, height)) {
+                Reply(out, "ERROR expected width,height");
+                return true;
+            }
+            Start(width, height, out);
+            return true;
+        }
+
+        if (!started_) {
+            Reply(out, "ERROR game not started");
+            return true;
+        }
+
+        if (command == "RESTART") {
+            game_.Reset();
+            ReloadWeights();
+            Reply(out, "OK");
+        } else if (command == "BEGIN") {
+            Think(out);
+        } else if (command == "TURN") {
+            int x = 0, y = 0;
+            if (!ParseXY(args, x, y) || !game_.MakeMove(x, y, O)) {
+                Reply(out, "ERROR invalid move " + args);
+                return true;
+            }
+            Think(out);
+        } else if (command == "BOARD") {
+            Board(in, out);
+        } else if (command == "TAKEBACK") {
+            int x = 0, y = 0;
+            if (!ParseXY(args, x, y) || !game_.TakeBack(x, y)) {
+                Reply(out, "ERROR invalid takeback " + args);
+                return true;
+            }
+            Reply(out, "OK");
+        } else {
+            Reply(out, "UNKNOWN " + command);
+        }
+        return true;
+    }
+
+    [[nodiscard]] const TicTacToeGame& GetGame() const noexcept {
+        return game_;
+    }
+
+    [[nodiscard]] int GetWidth() const noexcept {
+        return width_;
+    }
+
+    [[nodiscard]] int GetHeight() const noexcept {
+        return height_;
+    }
+
+    // Срок, который получит поиск следующего хода
+    [[nodiscard]] std::chrono::milliseconds GetMoveBudget() const {
+        return MoveBudget();
+    }
+};
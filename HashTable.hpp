@@ -27,6 +27,49 @@ private:
         return hashFunc_(key) % capacity_;
     }
 
+    static void prefetch(const void* address) {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(address, 0, 3);
+#else
+        (void)address;
+#endif
+    }
+
+    // Размер порции пакетных операций: индексы порции живут на стеке
+    static constexpr std::size_t kBatchChunk = 16;
+
+    // Пакетный поиск в три прохода по порции ключей: посчитать все
+    // индексы и подгрузить заголовки корзин, затем подгрузить сами
+    // цепочки, и только потом сравнивать ключи. Промахи кэша для разных
+    // ключей при этом перекрываются, а не ждут друг друга.
+    template<typename OnResult>
+    void lookupBatch(const TKey* keys, std::size_t n, OnResult&& onResult) const {
+        std::size_t indices[kBatchChunk];
+
+        for (std::size_t base = 0; base < n; base += kBatchChunk) {
+            std::size_t count = n - base < kBatchChunk ? n - base : kBatchChunk;
+
+            for (std::size_t i = 0; i < count; ++i) {
+                indices[i] = getIndex(keys[base + i]);
+                prefetch(&table_[indices[i]]);
+            }
+            for (std::size_t i = 0; i < count; ++i) {
+                prefetch(table_[indices[i]].begin());
+            }
+            for (std::size_t i = 0; i < count; ++i) {
+                const DynamicArray<Entry>& chain = table_[indices[i]];
+                const Entry* match = nullptr;
+                for (std::size_t j = 0; j < chain.size(); ++j) {
+                    if (chain[j].key == keys[base + i]) {
+                        match = &chain[j];
+                        break;
+                    }
+                }
+                onResult(base + i, match);
+            }
+        }
+    }
+
 public:
     // Вариант для C++17: всегда явно передаём хеш-функцию.
     explicit HashTable(std::size_t initialCapacity,
@@ -81,6 +124,28 @@ public:
         return false;
     }
 
+    // out[i] = ContainsKey(keys[i])
+    void ContainsBatch(const TKey* keys, std::size_t n, bool* out) const {
+        lookupBatch(keys, n, [out](std::size_t i, const Entry* e) {
+            out[i] = (e != nullptr);
+        });
+    }
+
+    // Для найденных ключей пишет значение в values[i] и found[i] = true;
+    // для отсутствующих values[i] не трогается. Возвращает число найденных.
+    std::size_t GetBatch(const TKey* keys, std::size_t n,
+                         TValue* values, bool* found) const {
+        std::size_t hits = 0;
+        lookupBatch(keys, n, [&](std::size_t i, const Entry* e) {
+            found[i] = (e != nullptr);
+            if (e != nullptr) {
+                values[i] = e->value;
+                ++hits;
+            }
+        });
+        return hits;
+    }
+
     void Remove(const TKey& key) {
         std::size_t index = getIndex(key);
         DynamicArray<Entry>& chain = table_[index];
@@ -107,6 +172,17 @@ public:
         return capacity_;
     }
 
+    // Обход всех пар (ключ, значение) без копирования ключей в массив
+    template<typename Func>
+    void ForEach(Func&& func) const {
+        for (std::size_t i = 0; i < capacity_; ++i) {
+            const DynamicArray<Entry>& chain = table_[i];
+            for (std::size_t j = 0; j < chain.size(); ++j) {
+                func(chain[j].key, chain[j].value);
+            }
+        }
+    }
+
     [[nodiscard]] DynamicArray<TKey> GetKeys() const {
         DynamicArray<TKey> keys;
         keys.reserve(count_);
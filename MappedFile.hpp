@@ -0,0 +1,139 @@
+// MappedFile.hpp
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Файл, отображённый в память только для чтения (RAII).
+// Содержимое доступно сразу после Open(), без чтения и разбора.
+class MappedFile {
+private:
+    const unsigned char* data_;
+    std::size_t size_;
+
+#ifdef _WIN32
+    HANDLE file_;
+    HANDLE mapping_;
+#endif
+
+public:
+    MappedFile()
+        : data_(nullptr),
+          size_(0)
+#ifdef _WIN32
+          , file_(INVALID_HANDLE_VALUE),
+          mapping_(nullptr)
+#endif
+    {}
+
+    ~MappedFile() {
+        Close();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::string& path) {
+        Close();
+
+#ifdef _WIN32
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file_, &fileSize) || fileSize.QuadPart == 0) {
+            Close();
+            return false;
+        }
+
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY,
+                                      0, 0, nullptr);
+        if (mapping_ == nullptr) {
+            Close();
+            return false;
+        }
+
+        void* view = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+        if (view == nullptr) {
+            Close();
+            return false;
+        }
+
+        data_ = static_cast<const unsigned char*>(view);
+        size_ = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+
+        void* view = ::mmap(nullptr, static_cast<std::size_t>(st.st_size),
+                            PROT_READ, MAP_PRIVATE, fd, 0);
+        // Дескриптор после mmap больше не нужен
+        ::close(fd);
+        if (view == MAP_FAILED) {
+            return false;
+        }
+
+        data_ = static_cast<const unsigned char*>(view);
+        size_ = static_cast<std::size_t>(st.st_size);
+#endif
+        return true;
+    }
+
+    void Close() {
+#ifdef _WIN32
+        if (data_ != nullptr) {
+            UnmapViewOfFile(data_);
+        }
+        if (mapping_ != nullptr) {
+            CloseHandle(mapping_);
+            mapping_ = nullptr;
+        }
+        if (file_ != INVALID_HANDLE_VALUE) {
+            CloseHandle(file_);
+            file_ = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (data_ != nullptr) {
+            ::munmap(const_cast<unsigned char*>(data_), size_);
+        }
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    [[nodiscard]] bool IsOpen() const noexcept {
+        return data_ != nullptr;
+    }
+
+    [[nodiscard]] const unsigned char* Data() const noexcept {
+        return data_;
+    }
+
+    [[nodiscard]] std::size_t Size() const noexcept {
+        return size_;
+    }
+};
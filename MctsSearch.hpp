@@ -0,0 +1,608 @@
+// MctsSearch.hpp
+#pragma once
+
+#include "TicTacToe.hpp"
+#include "SearchState.hpp"
+#include "DynamicArray.hpp"
+#include "Trace.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <thread>
+
+struct MctsSettings {
+    int iterations = 20000;             // плейаутов на ход (FindBestMove)
+    std::size_t threads = 1;            // потоков на одно дерево
+    double exploration = 1.0;           // C в UCT: Q + C * sqrt(ln N / n)
+    int playoutPlies = 30;              // дальше — статическая оценка
+    int virtualLoss = 3;                // «проигрышей» на узел в работе
+    std::size_t nodeCapacity = 1 << 18; // узлов в пуле
+    bool reuseTree = true;              // переносить поддерево между ходами
+    std::uint32_t seed = 1;
+};
+
+// Поиск Монте-Карло по дереву (UCT) — альтернатива minimax для открытых
+// позиций, где ширины 15–20 ходов не хватает.
+//
+// Дети узла — все кандидаты SearchState::GenerateMoves, без отбора по
+// оценке. Узлы лежат в пуле фиксированного размера, дети одного узла —
+// подряд; когда пул кончился, листья перестают раскрываться, но
+// плейауты продолжаются. Плейаут — случайные ходы рядом со случайным
+// камнем на SearchState потока (без обращений к куче), победа
+// проверяется по четырём линиям через последний ход; если за
+// playoutPlies никто не выиграл, исход берётся из статической оценки.
+//
+// Несколько потоков спускаются по одному дереву (tree parallelism):
+// счётчики узлов атомарные, а пока поток внутри узла, узел получает
+// виртуальные проигрыши — остальные потоки охотнее выбирают соседей.
+//
+// Дерево переживает ход: если новая позиция — это корень прошлого
+// поиска плюс не больше двух ходов по дереву (наш ход и ответ),
+// поддерево переносится в начало запасного пула и поиск продолжается
+// с накопленной статистикой.
+class MctsSearch {
+private:
+    enum NodeState : std::uint8_t {
+        UNEXPANDED,
+        EXPANDING,
+        EXPANDED,
+        LEAF            // пул кончился, узел не раскрывается
+    };
+
+    enum Outcome : std::uint8_t {
+        UNKNOWN,
+        ONGOING,
+        WIN             // ход в узел выиграл партию
+    };
+
+    struct Node {
+        Position move;                      // ход, которым пришли в узел
+        std::uint32_t firstChild;
+        std::uint32_t childCount;
+        std::atomic<std::uint8_t> state;
+        std::atomic<std::uint8_t> outcome;
+        std::atomic<std::int32_t> visits;
+        std::atomic<std::int32_t> virtualLoss;
+        std::atomic<std::int64_t> value;    // сумма исходов для ходившего
+    };
+
+    // Рабочее место потока: своя доска, путь по дереву, генератор
+    struct Worker {
+        SearchState state;
+        DynamicArray<std::uint32_t> path;
+        std::uint64_t random = 0;
+    };
+
+    // Исход партии в долях kValueScale: kValueScale — победа X
+    static constexpr std::int64_t kValueScale = 1000;
+    // Масштаб статической оценки для перевода в вероятность победы
+    static constexpr double kEvalScale = 300.0;
+    static constexpr std::uint32_t kNone = 0xffffffffu;
+    static constexpr int kMaxTreePly = 64;
+
+    MctsSettings settings_;
+    Node* nodes_;
+    Node* spare_;                   // для переноса поддерева
+    DynamicArray<std::uint32_t> remap_;
+    std::atomic<std::uint64_t> used_;
+    DynamicArray<Worker> workers_;
+
+    // Корень дерева: какая позиция и кто в ней ходит
+    bool hasTree_;
+    std::uint64_t rootHash_;
+    std::size_t rootStones_;
+    Cell rootPlayer_;
+    int rootWinLength_;
+    BoardBounds rootBounds_;
+    std::uint64_t searchCount_;
+
+    long long lastIterations_;
+    long long reusedVisits_;
+
+    static Cell Opponent(Cell player) noexcept {
+        return player == X ? O : X;
+    }
+
+    // xorshift64*
+    static std::uint64_t NextRandom(std::uint64_t& s) noexcept {
+        s ^= s >> 12;
+        s ^= s << 25;
+        s ^= s >> 27;
+        return s * 0x2545f4914f6cdd1dULL;
+    }
+
+    static void InitNode(Node& node, const Position& move) {
+        node.move = move;
+        node.firstChild = kNone;
+        node.childCount = 0;
+        node.state.store(UNEXPANDED, std::memory_order_relaxed);
+        node.outcome.store(UNKNOWN, std::memory_order_relaxed);
+        node.visits.store(0, std::memory_order_relaxed);
+        node.virtualLoss.store(0, std::memory_order_relaxed);
+        node.value.store(0, std::memory_order_relaxed);
+    }
+
+    void AllocatePools() {
+        if (nodes_ == nullptr) {
+            nodes_ = new Node[settings_.nodeCapacity];
+        }
+    }
+
+    [[nodiscard]] std::uint32_t AllocateNodes(std::size_t count) {
+        std::uint64_t first = used_.fetch_add(count, std::memory_order_relaxed);
+        if (first + count > settings_.nodeCapacity) {
+            return kNone;
+        }
+        return static_cast<std::uint32_t>(first);
+    }
+
+    // Раскрыть узел, позиция которого стоит на state; false — узел
+    // раскрывает другой поток или пул кончился
+    bool TryExpand(Node& node, SearchState& state) {
+        std::uint8_t expected = UNEXPANDED;
+        if (!node.state.compare_exchange_strong(expected, EXPANDING,
+                                                std::memory_order_acquire)) {
+            return false;
+        }
+
+        const DynamicArray<Position>& moves = state.GenerateMoves(0);
+        std::uint32_t first = moves.empty() ? 0 : AllocateNodes(moves.size());
+        if (first == kNone) {
+            node.state.store(LEAF, std::memory_order_release);
+            return false;
+        }
+        for (std::size_t i = 0; i < moves.size(); ++i) {
+            InitNode(nodes_[first + i], moves[i]);
+        }
+        node.firstChild = first;
+        node.childCount = static_cast<std::uint32_t>(moves.size());
+        node.state.store(EXPANDED, std::memory_order_release);
+        return true;
+    }
+
+    // UCT с виртуальными проигрышами; выигрывающий ход берётся сразу
+    [[nodiscard]] std::uint32_t SelectChild(const Node& node) const {
+        const double parentVisits = static_cast<double>(
+            node.visits.load(std::memory_order_relaxed) +
+            node.virtualLoss.load(std::memory_order_relaxed));
+        const double logParent = std::log(parentVisits > 1.0 ? parentVisits
+                                                             : 1.0);
+
+        std::uint32_t best = node.firstChild;
+        double bestScore = -std::numeric_limits<double>::infinity();
+        for (std::uint32_t i = 0; i < node.childCount; ++i) {
+            std::uint32_t index = node.firstChild + i;
+            const Node& child = nodes_[index];
+            if (child.outcome.load(std::memory_order_relaxed) == WIN) {
+                return index;
+            }
+            std::int64_t n = child.visits.load(std::memory_order_relaxed) +
+                             child.virtualLoss.load(std::memory_order_relaxed);
+            if (n == 0) {
+                return index;
+            }
+            double visits = static_cast<double>(n);
+            double q = static_cast<double>(
+                           child.value.load(std::memory_order_relaxed)) /
+                       (static_cast<double>(kValueScale) * visits);
+            double score = q + settings_.exploration *
+                                   std::sqrt(logParent / visits);
+            if (score > bestScore) {
+                bestScore = score;
+                best = index;
+            }
+        }
+        return best;
+    }
+
+    // Случайная пустая клетка рядом со случайным камнем; если несколько
+    // попыток не удались — случайный из всех кандидатов
+    static bool RandomMove(SearchState& state, std::uint64_t& random,
+                           Position& move) {
+        static constexpr int kNeighbours[8][2] = {
+            {-1, -1}, {-1, 0}, {-1, 1}, {0, -1},
+            {0, 1}, {1, -1}, {1, 0}, {1, 1}
+        };
+        const DynamicArray<Stone>& stones = state.GetStones();
+        const BoardBounds& bounds = state.GetBounds();
+
+        if (!stones.empty()) {
+            for (int attempt = 0; attempt < 16; ++attempt) {
+                std::uint64_t r = NextRandom(random);
+                const Stone& s = stones[static_cast<std::size_t>(
+                    (r >> 3) % stones.size())];
+                const int* offset = kNeighbours[r & 7];
+                Position p(s.pos.x + offset[0], s.pos.y + offset[1]);
+                if (bounds.Contains(p.x, p.y) && state.At(p.x, p.y) == EMPTY) {
+                    move = p;
+                    return true;
+                }
+            }
+        }
+
+        const DynamicArray<Position>& moves = state.GenerateMoves(0);
+        if (moves.empty()) {
+            return false;
+        }
+        move = moves[static_cast<std::size_t>(NextRandom(random) %
+                                              moves.size())];
+        return true;
+    }
+
+    // Доигрывание со случайными ходами; возвращает исход для X
+    [[nodiscard]] std::int64_t Playout(SearchState& state, Cell toMove,
+                                       std::uint64_t& random) const {
+        Cell winner = EMPTY;
+        int played = 0;
+        while (played < settings_.playoutPlies) {
+            Position move;
+            if (!RandomMove(state, random, move)) {
+                break;
+            }
+            state.MakeMove(move, toMove);
+            ++played;
+            if (state.CheckWinAt(move, toMove)) {
+                winner = toMove;
+                break;
+            }
+            toMove = Opponent(toMove);
+        }
+
+        std::int64_t value = kValueScale / 2;
+        if (winner == X) {
+            value = kValueScale;
+        } else if (winner == O) {
+            value = 0;
+        } else if (played == settings_.playoutPlies) {
+            // Конец плейаута оценивается один раз: ступени Evaluate с
+            // запоминанием сумм здесь только лишняя работа
+            double eval = static_cast<double>(state.EvaluateScanFixed<0>(X));
+            value = static_cast<std::int64_t>(
+                static_cast<double>(kValueScale) /
+                (1.0 + std::exp(-eval / kEvalScale)));
+        }
+
+        for (int i = 0; i < played; ++i) {
+            state.UndoMove();
+        }
+        return value;
+    }
+
+    // Один спуск: выбор, раскрытие, плейаут, обратное распространение
+    void Iterate(Worker& worker) {
+        SearchState& state = worker.state;
+        DynamicArray<std::uint32_t>& path = worker.path;
+        const std::int32_t virtualLoss = settings_.virtualLoss;
+
+        path.clear();
+        std::uint32_t index = 0;
+        Cell toMove = rootPlayer_;
+        int moves = 0;
+        std::int64_t valueForX = kValueScale / 2;
+
+        while (true) {
+            Node& node = nodes_[index];
+            path.push_back(index);
+            node.virtualLoss.fetch_add(virtualLoss, std::memory_order_relaxed);
+
+            if (index != 0) {
+                std::uint8_t outcome =
+                    node.outcome.load(std::memory_order_relaxed);
+                if (outcome == UNKNOWN) {
+                    outcome = state.CheckWinAt(node.move, Opponent(toMove))
+                                  ? WIN : ONGOING;
+                    node.outcome.store(outcome, std::memory_order_relaxed);
+                }
+                if (outcome == WIN) {
+                    valueForX = Opponent(toMove) == X ? kValueScale : 0;
+                    break;
+                }
+            }
+
+            std::uint8_t nodeState = node.state.load(std::memory_order_acquire);
+            if (nodeState == UNEXPANDED &&
+                node.visits.load(std::memory_order_relaxed) > 0 &&
+                moves < kMaxTreePly && TryExpand(node, state)) {
+                nodeState = EXPANDED;
+            }
+            if (nodeState != EXPANDED) {
+                valueForX = Playout(state, toMove, worker.random);
+                break;
+            }
+            if (node.childCount == 0) {
+                break;              // некуда ходить — ничья
+            }
+
+            index = SelectChild(node);
+            state.MakeMove(nodes_[index].move, toMove);
+            ++moves;
+            toMove = Opponent(toMove);
+        }
+
+        for (int i = 0; i < moves; ++i) {
+            state.UndoMove();
+        }
+
+        // Узел на глубине d сходил игрок, противоположный ходящему в нём
+        Cell mover = Opponent(rootPlayer_);
+        for (std::uint32_t i : path) {
+            Node& node = nodes_[i];
+            node.value.fetch_add(mover == X ? valueForX
+                                            : kValueScale - valueForX,
+                                 std::memory_order_relaxed);
+            node.visits.fetch_add(1, std::memory_order_relaxed);
+            node.virtualLoss.fetch_sub(virtualLoss, std::memory_order_relaxed);
+            mover = Opponent(mover);
+        }
+    }
+
+    // Узел на глубине depth под index с позицией target и ходящим player
+    [[nodiscard]] std::uint32_t FindDescendant(std::uint32_t index,
+                                               std::uint64_t hash,
+                                               Cell toMove, std::size_t depth,
+                                               std::uint64_t target,
+                                               Cell player) const {
+        if (depth == 0) {
+            return (hash == target && toMove == player) ? index : kNone;
+        }
+        const Node& node = nodes_[index];
+        if (node.state.load(std::memory_order_relaxed) != EXPANDED) {
+            return kNone;
+        }
+        for (std::uint32_t i = 0; i < node.childCount; ++i) {
+            std::uint32_t child = node.firstChild + i;
+            const Position& m = nodes_[child].move;
+            std::uint32_t found = FindDescendant(
+                child, hash ^ StoneHash(m.x, m.y, toMove), Opponent(toMove),
+                depth - 1, target, player);
+            if (found != kNone) {
+                return found;
+            }
+        }
+        return kNone;
+    }
+
+    static void CopyNode(Node& dst, const Node& src) {
+        dst.move = src.move;
+        dst.firstChild = kNone;
+        dst.childCount = 0;
+        std::uint8_t state = src.state.load(std::memory_order_relaxed);
+        dst.state.store(state == EXPANDED ? EXPANDED : UNEXPANDED,
+                        std::memory_order_relaxed);
+        dst.outcome.store(src.outcome.load(std::memory_order_relaxed),
+                          std::memory_order_relaxed);
+        dst.visits.store(src.visits.load(std::memory_order_relaxed),
+                         std::memory_order_relaxed);
+        dst.virtualLoss.store(0, std::memory_order_relaxed);
+        dst.value.store(src.value.load(std::memory_order_relaxed),
+                        std::memory_order_relaxed);
+    }
+
+    // Переносит поддерево root в начало запасного пула обходом в
+    // ширину (дети узла остаются подряд) и меняет пулы местами
+    void Compact(std::uint32_t root) {
+        if (spare_ == nullptr) {
+            spare_ = new Node[settings_.nodeCapacity];
+            remap_.reserve(settings_.nodeCapacity);
+        }
+        remap_.clear();
+
+        CopyNode(spare_[0], nodes_[root]);
+        remap_.push_back(root);
+        for (std::size_t k = 0; k < remap_.size(); ++k) {
+            const Node& src = nodes_[remap_[k]];
+            if (spare_[k].state.load(std::memory_order_relaxed) != EXPANDED) {
+                continue;
+            }
+            spare_[k].firstChild = static_cast<std::uint32_t>(remap_.size());
+            spare_[k].childCount = src.childCount;
+            for (std::uint32_t i = 0; i < src.childCount; ++i) {
+                CopyNode(spare_[remap_.size()], nodes_[src.firstChild + i]);
+                remap_.push_back(src.firstChild + i);
+            }
+        }
+
+        std::swap(nodes_, spare_);
+        used_.store(remap_.size(), std::memory_order_relaxed);
+    }
+
+    // Корень для позиции: найденный в старом дереве или новый
+    void PrepareRoot(std::uint64_t hash, std::size_t stones, Cell player,
+                     int winLength, const BoardBounds& bounds) {
+        reusedVisits_ = 0;
+        bool sameRules = hasTree_ && winLength == rootWinLength_ &&
+                         bounds.minX == rootBounds_.minX &&
+                         bounds.minY == rootBounds_.minY &&
+                         bounds.maxX == rootBounds_.maxX &&
+                         bounds.maxY == rootBounds_.maxY;
+        if (settings_.reuseTree && sameRules && stones >= rootStones_ &&
+            stones - rootStones_ <= 2) {
+            std::uint32_t found = FindDescendant(0, rootHash_, rootPlayer_,
+                                                 stones - rootStones_, hash,
+                                                 player);
+            if (found != kNone) {
+                if (found != 0) {
+                    Compact(found);
+                }
+                reusedVisits_ = nodes_[0].visits.load(std::memory_order_relaxed);
+            }
+        }
+
+        if (reusedVisits_ == 0) {
+            InitNode(nodes_[0], Position());
+            used_.store(1, std::memory_order_relaxed);
+        }
+
+        hasTree_ = true;
+        rootHash_ = hash;
+        rootStones_ = stones;
+        rootPlayer_ = player;
+        rootWinLength_ = winLength;
+        rootBounds_ = bounds;
+    }
+
+    template<int WinLength>
+    Position Search(const BasicTicTacToeGame<WinLength>& game, Cell player,
+                    long long iterations, bool timed,
+                    std::chrono::steady_clock::time_point deadline) {
+        TraceScope trace("MctsSearch", "search", iterations);
+        AllocatePools();
+
+        std::size_t threads = settings_.threads > 0 ? settings_.threads : 1;
+        while (workers_.size() < threads) {
+            workers_.push_back(Worker());
+        }
+        ++searchCount_;
+
+        const DynamicArray<Stone> stones = game.GetStones();
+        const int maxPly = kMaxTreePly + settings_.playoutPlies + 1;
+        Worker& main = workers_[0];
+        main.state.Load(stones, game.GetWinLength(), maxPly,
+                        game.GetBoardBounds());
+
+        PrepareRoot(main.state.Hash(), stones.size(), player,
+                    game.GetWinLength(), game.GetBoardBounds());
+        Node& root = nodes_[0];
+        if (root.state.load(std::memory_order_relaxed) == UNEXPANDED) {
+            TryExpand(root, main.state);
+        }
+
+        std::atomic<long long> remaining(iterations);
+        std::atomic<long long> done(0);
+        auto work = [&](std::size_t t) {
+            Worker& worker = workers_[t];
+            if (t > 0) {
+                if (Tracer::IsEnabled()) {
+                    Tracer::SetThreadName("mcts " + std::to_string(t));
+                }
+                worker.state.Load(stones, game.GetWinLength(), maxPly,
+                                  game.GetBoardBounds());
+            }
+            worker.path.reserve(kMaxTreePly + 1);
+            worker.random = HashMix64(settings_.seed + searchCount_ * 977 + t);
+
+            long long count = 0;
+            while (remaining.fetch_sub(1, std::memory_order_relaxed) > 0) {
+                if (timed && (count & 63) == 0 &&
+                    std::chrono::steady_clock::now() >= deadline) {
+                    break;
+                }
+                Iterate(worker);
+                ++count;
+            }
+            done.fetch_add(count, std::memory_order_relaxed);
+        };
+
+        if (root.childCount > 1) {
+            DynamicArray<std::thread> helpers;
+            for (std::size_t t = 1; t < threads; ++t) {
+                helpers.push_back(std::thread(work, t));
+            }
+            work(0);
+            for (auto& helper : helpers) {
+                helper.join();
+            }
+        }
+        lastIterations_ = done.load();
+
+        // Самый посещённый ход; при равенстве — с лучшим средним
+        if (root.childCount == 0) {
+            return Position();
+        }
+        std::uint32_t best = root.firstChild;
+        for (std::uint32_t i = 1; i < root.childCount; ++i) {
+            const Node& c = nodes_[root.firstChild + i];
+            const Node& b = nodes_[best];
+            std::int64_t cv = c.visits.load(std::memory_order_relaxed);
+            std::int64_t bv = b.visits.load(std::memory_order_relaxed);
+            if (cv > bv ||
+                (cv == bv && c.value.load(std::memory_order_relaxed) >
+                                 b.value.load(std::memory_order_relaxed))) {
+                best = root.firstChild + i;
+            }
+        }
+        return nodes_[best].move;
+    }
+
+public:
+    explicit MctsSearch(const MctsSettings& settings = MctsSettings())
+        : settings_(settings),
+          nodes_(nullptr),
+          spare_(nullptr),
+          remap_(),
+          used_(0),
+          workers_(),
+          hasTree_(false),
+          rootHash_(0),
+          rootStones_(0),
+          rootPlayer_(X),
+          rootWinLength_(0),
+          rootBounds_(),
+          searchCount_(0),
+          lastIterations_(0),
+          reusedVisits_(0) {
+        if (settings_.nodeCapacity < 2) {
+            settings_.nodeCapacity = 2;
+        }
+    }
+
+    ~MctsSearch() {
+        delete[] nodes_;
+        delete[] spare_;
+    }
+
+    MctsSearch(const MctsSearch&) = delete;
+    MctsSearch& operator=(const MctsSearch&) = delete;
+
+    // settings_.iterations плейаутов
+    template<int WinLength>
+    [[nodiscard]] Position FindBestMove(
+            const BasicTicTacToeGame<WinLength>& game, Cell player) {
+        return Search(game, player, settings_.iterations, false,
+                      std::chrono::steady_clock::time_point());
+    }
+
+    // Плейауты, пока не истечёт budget
+    template<int WinLength>
+    [[nodiscard]] Position FindBestMoveTimed(
+            const BasicTicTacToeGame<WinLength>& game, Cell player,
+            std::chrono::milliseconds budget) {
+        return Search(game, player, std::numeric_limits<long long>::max(),
+                      true, std::chrono::steady_clock::now() + budget);
+    }
+
+    // Забыть дерево (например, перед новой партией)
+    void ClearTree() {
+        hasTree_ = false;
+    }
+
+    [[nodiscard]] const MctsSettings& GetSettings() const noexcept {
+        return settings_;
+    }
+
+    // Плейаутов в последнем поиске
+    [[nodiscard]] long long GetLastIterations() const noexcept {
+        return lastIterations_;
+    }
+
+    // Посещений корня, перенесённых из прошлого поиска
+    [[nodiscard]] long long GetReusedVisits() const noexcept {
+        return reusedVisits_;
+    }
+
+    [[nodiscard]] long long GetRootVisits() const {
+        return nodes_ == nullptr
+                   ? 0 : nodes_[0].visits.load(std::memory_order_relaxed);
+    }
+
+    // Занято узлов в пуле
+    [[nodiscard]] std::size_t GetNodeCount() const {
+        std::uint64_t used = used_.load(std::memory_order_relaxed);
+        return static_cast<std::size_t>(
+            used < settings_.nodeCapacity ? used : settings_.nodeCapacity);
+    }
+};
@@ -0,0 +1,486 @@
+// NnueNetwork.hpp
+#pragma once
+
+#include "Position.hpp"
+#include "DynamicArray.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+// Векторные ядра AVX2 собираются для x86 под GCC/Clang и выбираются при
+// запуске, если процессор их поддерживает; иначе — скалярные. Сборка с
+// -DTTT_NNUE_SIMD=0 оставляет только скалярные ядра.
+#ifndef TTT_NNUE_SIMD
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define TTT_NNUE_SIMD 1
+#else
+#define TTT_NNUE_SIMD 0
+#endif
+#endif
+
+#if TTT_NNUE_SIMD
+#include <immintrin.h>
+#endif
+
+// Оценка маленькой сетью с инкрементально обновляемым первым слоем
+// (схема NNUE).
+//
+// Признаки — окна из winLength клеток на линиях четырёх направлений:
+// признак окна — пара (своих камней, чужих камней), всего
+// (winLength + 1)^2 признаков, веса у направлений общие. Пустые окна
+// признаков не дают. Первый слой — сумма строк весов всех окон доски
+// плюс смещение, kHidden чисел int16 на каждую сторону («аккумулятор»).
+// Камень меняет только 4 * winLength окон через свою клетку, поэтому
+// после хода аккумулятор обновляется прибавлением и вычитанием строк,
+// а при отмене хода берётся сохранённый (стек в SearchState).
+//
+// Выход: clamp(acc, 0, 127) своей стороны и соперника (uint8) скалярно
+// умножаются на 2 * kHidden весов int8, плюс смещение; результат
+// умножается на outputScale и сдвигается на outputShift. Оценка сети
+// ограничена ±(kWinScore - 1): выигрыш определяет не сеть, а счётчик
+// собранных окон в аккумуляторе.
+//
+// Формат файла весов (little-endian, как в памяти):
+//
+//   NnueFileHeader                          — 32 байта
+//   std::int16_t featureWeights[F][kHidden] — F = (winLength + 1)^2
+//   std::int16_t hiddenBias[kHidden]
+//   std::int8_t  outputWeights[2 * kHidden] — сначала своя сторона
+//   std::int32_t outputBias
+
+struct NnueFileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t winLength;
+    std::uint32_t hidden;
+    std::int32_t outputScale;
+    std::uint32_t outputShift;
+    std::uint32_t reserved;
+};
+
+static_assert(sizeof(NnueFileHeader) == 32, "unexpected nnue header size");
+
+namespace nnue_detail {
+
+constexpr char kMagic[8] = { 'T', 'T', 'T', 'N', 'N', 'U', 'E', '1' };
+constexpr std::uint32_t kVersion = 1;
+constexpr int kHidden = 32;
+
+inline bool CpuHasAvx2() {
+#if TTT_NNUE_SIMD
+    static const bool has = __builtin_cpu_supports("avx2") != 0;
+    return has;
+#else
+    return false;
+#endif
+}
+
+// acc += add - sub; sub может быть nullptr
+inline void UpdateRowScalar(std::int16_t* acc, const std::int16_t* sub,
+                            const std::int16_t* add) {
+    for (int i = 0; i < kHidden; ++i) {
+        int value = acc[i] + add[i] - (sub != nullptr ? sub[i] : 0);
+        acc[i] = static_cast<std::int16_t>(value);
+    }
+}
+
+inline std::int32_t DotScalar(const std::int16_t* us, const std::int16_t* them,
+                              const std::int8_t* weights) {
+    std::int32_t sum = 0;
+    for (int i = 0; i < kHidden; ++i) {
+        int a = std::min(std::max(static_cast<int>(us[i]), 0), 127);
+        int b = std::min(std::max(static_cast<int>(them[i]), 0), 127);
+        sum += a * weights[i] + b * weights[kHidden + i];
+    }
+    return sum;
+}
+
+#if TTT_NNUE_SIMD
+__attribute__((target("avx2")))
+inline void UpdateRowAvx2(std::int16_t* acc, const std::int16_t* sub,
+                          const std::int16_t* add) {
+    for (int i = 0; i < kHidden; i += 16) {
+        __m256i* p = reinterpret_cast<__m256i*>(acc + i);
+        __m256i v = _mm256_add_epi16(
+            _mm256_loadu_si256(p),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(add + i)));
+        if (sub != nullptr) {
+            v = _mm256_sub_epi16(v, _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(sub + i)));
+        }
+        _mm256_storeu_si256(p, v);
+    }
+}
+
+// Половина выхода: 32 значения int16 → uint8 и произведение с int8.
+// maddubs не насыщается: |127 * w1 + 127 * w2| <= 32512
+__attribute__((target("avx2")))
+inline __m256i DotHalfAvx2(const std::int16_t* acc,
+                           const std::int8_t* weights) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i top = _mm256_set1_epi16(127);
+    __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(acc));
+    __m256i hi = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(acc + 16));
+    lo = _mm256_min_epi16(_mm256_max_epi16(lo, zero), top);
+    hi = _mm256_min_epi16(_mm256_max_epi16(hi, zero), top);
+    // packus перемежает 128-битные половины — возвращаем порядок
+    __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi),
+                                             0xD8);
+    __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights));
+    return _mm256_madd_epi16(_mm256_maddubs_epi16(bytes, w),
+                             _mm256_set1_epi16(1));
+}
+
+__attribute__((target("avx2")))
+inline std::int32_t DotAvx2(const std::int16_t* us, const std::int16_t* them,
+                            const std::int8_t* weights) {
+    static_assert(kHidden == 32, "DotAvx2 expects 32 hidden units");
+    __m256i sum = _mm256_add_epi32(DotHalfAvx2(us, weights),
+                                   DotHalfAvx2(them, weights + kHidden));
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum),
+                              _mm256_extracti128_si256(sum, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+    return _mm_cvtsi128_si32(s);
+}
+#endif
+
+}  // namespace nnue_detail
+
+// Первый слой для позиции: [0] — со стороны X (свои — X), [1] — со
+// стороны O; completed — сколько окон целиком заняты X и O (есть ли
+// собранная линия)
+struct NnueAccumulator {
+    alignas(32) std::int16_t values[2][nnue_detail::kHidden];
+    std::int32_t completed[2];
+};
+
+class NnueNetwork {
+public:
+    static constexpr int kHidden = nnue_detail::kHidden;
+    static constexpr int kMaxWinLength = 16;
+    static constexpr int kWinScore = 10000;     // как у оценки по линиям
+
+private:
+    int winLength_;
+    int featureCount_;
+    DynamicArray<std::int16_t> featureWeights_;  // [featureCount_][kHidden]
+    std::int16_t hiddenBias_[kHidden];
+    std::int8_t outputWeights_[2 * kHidden];
+    std::int32_t outputBias_;
+    std::int32_t outputScale_;
+    int outputShift_;
+    bool useSimd_;
+
+    [[nodiscard]] const std::int16_t* Row(int feature) const {
+        return featureWeights_.begin() +
+               static_cast<std::size_t>(feature) * kHidden;
+    }
+
+    void UpdateRow(std::int16_t* acc, const std::int16_t* sub,
+                   const std::int16_t* add) const {
+#if TTT_NNUE_SIMD
+        if (useSimd_) {
+            nnue_detail::UpdateRowAvx2(acc, sub, add);
+            return;
+        }
+#endif
+        nnue_detail::UpdateRowScalar(acc, sub, add);
+    }
+
+    // Окно, где было xs камней X и os камней O, получило камень cell
+    void ChangeWindow(NnueAccumulator& acc, int xs, int os, Cell cell) const {
+        const int side = winLength_ + 1;
+        int nx = xs + (cell == X ? 1 : 0);
+        int no = os + (cell == O ? 1 : 0);
+        bool wasEmpty = (xs == 0 && os == 0);
+        UpdateRow(acc.values[0], wasEmpty ? nullptr : Row(xs * side + os),
+                  Row(nx * side + no));
+        UpdateRow(acc.values[1], wasEmpty ? nullptr : Row(os * side + xs),
+                  Row(no * side + nx));
+        if (nx == winLength_) {
+            ++acc.completed[0];
+        } else if (no == winLength_) {
+            ++acc.completed[1];
+        }
+    }
+
+public:
+    // Сеть с нулевыми весами
+    explicit NnueNetwork(int winLength = 5)
+        : winLength_(winLength),
+          featureCount_((winLength + 1) * (winLength + 1)),
+          featureWeights_(),
+          hiddenBias_(),
+          outputWeights_(),
+          outputBias_(0),
+          outputScale_(1),
+          outputShift_(0),
+          useSimd_(nnue_detail::CpuHasAvx2()) {
+
+        if (winLength < 1 || winLength > kMaxWinLength) {
+            throw std::invalid_argument("unsupported nnue win length");
+        }
+        std::size_t count = static_cast<std::size_t>(featureCount_) * kHidden;
+        featureWeights_ = DynamicArray<std::int16_t>(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            featureWeights_.push_back(0);
+        }
+    }
+
+    // Сеть, повторяющая оценку по линиям: нейрон c - 1 считает окна
+    // ровно с c своими камнями и без чужих, нейрон winLength - 1 + c - 1 —
+    // такие же окна соперника; выход — ±c^2 * 10 за окно. Отправная
+    // точка для обучения и замена оценки по линиям «из коробки»:
+    // счётчики окон насыщаются на 127.
+    static NnueNetwork CreatePattern(int winLength) {
+        NnueNetwork net(winLength);
+        if (2 * (winLength - 1) > kHidden) {
+            throw std::invalid_argument("pattern net needs more hidden units");
+        }
+        for (int c = 1; c < winLength; ++c) {
+            net.SetFeatureWeight(net.FeatureIndex(c, 0), c - 1, 1);
+            net.SetFeatureWeight(net.FeatureIndex(0, c), winLength - 1 + c - 1,
+                                 1);
+            std::int8_t weight = static_cast<std::int8_t>(
+                std::min(c * c, 127));
+            net.SetOutputWeight(c - 1, weight);
+            net.SetOutputWeight(winLength - 1 + c - 1,
+                                static_cast<std::int8_t>(-weight));
+        }
+        net.SetOutputScale(10, 0);
+        return net;
+    }
+
+    [[nodiscard]] int GetWinLength() const noexcept {
+        return winLength_;
+    }
+
+    [[nodiscard]] int GetFeatureCount() const noexcept {
+        return featureCount_;
+    }
+
+    [[nodiscard]] int FeatureIndex(int own, int opponent) const noexcept {
+        return own * (winLength_ + 1) + opponent;
+    }
+
+    [[nodiscard]] std::int16_t GetFeatureWeight(int feature, int unit) const {
+        return featureWeights_[static_cast<std::size_t>(feature) * kHidden +
+                               static_cast<std::size_t>(unit)];
+    }
+
+    void SetFeatureWeight(int feature, int unit, std::int16_t weight) {
+        featureWeights_[static_cast<std::size_t>(feature) * kHidden +
+                        static_cast<std::size_t>(unit)] = weight;
+    }
+
+    void SetHiddenBias(int unit, std::int16_t bias) {
+        hiddenBias_[unit] = bias;
+    }
+
+    [[nodiscard]] std::int8_t GetOutputWeight(int input) const {
+        return outputWeights_[input];
+    }
+
+    // input < kHidden — своя сторона, дальше — соперник
+    void SetOutputWeight(int input, std::int8_t weight) {
+        outputWeights_[input] = weight;
+    }
+
+    void SetOutputBias(std::int32_t bias) {
+        outputBias_ = bias;
+    }
+
+    void SetOutputScale(std::int32_t scale, int shift) {
+        outputScale_ = scale;
+        outputShift_ = shift;
+    }
+
+    // Векторные ядра (если процессор умеет) или скалярные; для
+    // сравнения в тестах и замеров
+    void SetUseSimd(bool use) {
+        useSimd_ = use && nnue_detail::CpuHasAvx2();
+    }
+
+    [[nodiscard]] bool IsUsingSimd() const noexcept {
+        return useSimd_;
+    }
+
+    // Аккумулятор пустой доски
+    void Reset(NnueAccumulator& acc) const {
+        for (int side = 0; side < 2; ++side) {
+            std::memcpy(acc.values[side], hiddenBias_, sizeof(hiddenBias_));
+            acc.completed[side] = 0;
+        }
+    }
+
+    // Камень cell ставится в пустую клетку pos; at(x, y) — клетки доски
+    // до хода. Меняются winLength окон в каждом из четырёх направлений.
+    template<typename CellAt>
+    void AddStone(NnueAccumulator& acc, const Position& pos, Cell cell,
+                  const CellAt& at) const {
+        static constexpr int kDirections[4][2] = {
+            {1, 0}, {0, 1}, {1, 1}, {1, -1}
+        };
+        const int span = winLength_ - 1;
+        Cell line[2 * kMaxWinLength - 1];
+
+        for (const auto& d : kDirections) {
+            for (int k = -span; k <= span; ++k) {
+                line[k + span] = (k == 0) ? EMPTY
+                                          : at(pos.x + k * d[0],
+                                               pos.y + k * d[1]);
+            }
+            int xs = 0;
+            int os = 0;
+            for (int k = 0; k < winLength_; ++k) {
+                xs += (line[k] == X);
+                os += (line[k] == O);
+            }
+            for (int start = 0; start <= span; ++start) {
+                if (start > 0) {
+                    Cell out = line[start - 1];
+                    Cell in = line[start + span];
+                    xs += (in == X) - (out == X);
+                    os += (in == O) - (out == O);
+                }
+                ChangeWindow(acc, xs, os, cell);
+            }
+        }
+    }
+
+    // Аккумулятор с нуля по всем камням stones (их клетки — at); для
+    // проверки инкрементального обновления
+    template<typename CellAt>
+    void Refresh(NnueAccumulator& acc, const DynamicArray<Stone>& stones,
+                 const CellAt& at) const {
+        static constexpr int kDirections[4][2] = {
+            {1, 0}, {0, 1}, {1, 1}, {1, -1}
+        };
+        const int side = winLength_ + 1;
+        Reset(acc);
+
+        for (const auto& s : stones) {
+            for (const auto& d : kDirections) {
+                for (int start = -(winLength_ - 1); start <= 0; ++start) {
+                    // Окно учитывает его первый камень
+                    bool first = true;
+                    int xs = 0;
+                    int os = 0;
+                    for (int k = start; k < start + winLength_; ++k) {
+                        Cell c = at(s.pos.x + k * d[0], s.pos.y + k * d[1]);
+                        if (k < 0 && c != EMPTY) {
+                            first = false;
+                            break;
+                        }
+                        xs += (c == X);
+                        os += (c == O);
+                    }
+                    if (!first) {
+                        continue;
+                    }
+                    UpdateRow(acc.values[0], nullptr, Row(xs * side + os));
+                    UpdateRow(acc.values[1], nullptr, Row(os * side + xs));
+                    acc.completed[0] += (xs == winLength_);
+                    acc.completed[1] += (os == winLength_);
+                }
+            }
+        }
+    }
+
+    // Оценка сети с точки зрения player, без проверки выигрыша
+    [[nodiscard]] int Evaluate(const NnueAccumulator& acc, Cell player) const {
+        const std::int16_t* us = acc.values[player == X ? 0 : 1];
+        const std::int16_t* them = acc.values[player == X ? 1 : 0];
+        std::int32_t sum;
+#if TTT_NNUE_SIMD
+        if (useSimd_) {
+            sum = nnue_detail::DotAvx2(us, them, outputWeights_);
+        } else
+#endif
+        {
+            sum = nnue_detail::DotScalar(us, them, outputWeights_);
+        }
+        std::int64_t score =
+            (static_cast<std::int64_t>(sum + outputBias_) * outputScale_) >>
+            outputShift_;
+        score = std::min<std::int64_t>(score, kWinScore - 1);
+        score = std::max<std::int64_t>(score, -(kWinScore - 1));
+        return static_cast<int>(score);
+    }
+
+    bool Save(const std::string& path) const {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            return false;
+        }
+
+        NnueFileHeader header{};
+        std::memcpy(header.magic, nnue_detail::kMagic,
+                    sizeof(nnue_detail::kMagic));
+        header.version = nnue_detail::kVersion;
+        header.winLength = static_cast<std::uint32_t>(winLength_);
+        header.hidden = kHidden;
+        header.outputScale = outputScale_;
+        header.outputShift = static_cast<std::uint32_t>(outputShift_);
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(featureWeights_.begin()),
+                  static_cast<std::streamsize>(
+                      featureWeights_.size() * sizeof(std::int16_t)));
+        out.write(reinterpret_cast<const char*>(hiddenBias_),
+                  sizeof(hiddenBias_));
+        out.write(reinterpret_cast<const char*>(outputWeights_),
+                  sizeof(outputWeights_));
+        out.write(reinterpret_cast<const char*>(&outputBias_),
+                  sizeof(outputBias_));
+        return static_cast<bool>(out);
+    }
+
+    // false — файл не открылся, не тот формат или обрезан; сеть тогда
+    // не меняется
+    bool Load(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in.is_open()) {
+            return false;
+        }
+
+        NnueFileHeader header{};
+        if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+            std::memcmp(header.magic, nnue_detail::kMagic,
+                        sizeof(nnue_detail::kMagic)) != 0 ||
+            header.version != nnue_detail::kVersion ||
+            header.hidden != static_cast<std::uint32_t>(kHidden) ||
+            header.winLength < 1 ||
+            header.winLength > static_cast<std::uint32_t>(kMaxWinLength) ||
+            header.outputShift > 31) {
+            return false;
+        }
+
+        NnueNetwork net(static_cast<int>(header.winLength));
+        net.outputScale_ = header.outputScale;
+        net.outputShift_ = static_cast<int>(header.outputShift);
+        in.read(reinterpret_cast<char*>(net.featureWeights_.begin()),
+                static_cast<std::streamsize>(
+                    net.featureWeights_.size() * sizeof(std::int16_t)));
+        in.read(reinterpret_cast<char*>(net.hiddenBias_),
+                sizeof(net.hiddenBias_));
+        in.read(reinterpret_cast<char*>(net.outputWeights_),
+                sizeof(net.outputWeights_));
+        in.read(reinterpret_cast<char*>(&net.outputBias_),
+                sizeof(net.outputBias_));
+        if (!in || in.peek() != std::ifstream::traits_type::eof()) {
+            return false;
+        }
+
+        net.useSimd_ = useSimd_;
+        *this = net;
+        return true;
+    }
+};
@@ -0,0 +1,336 @@
+// OpeningBook.hpp
+#pragma once
+
+#include "Position.hpp"
+#include "DynamicArray.hpp"
+#include "MappedFile.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+// Формат файла дебютной книги (little-endian, как в памяти):
+//
+//   OpeningBookHeader                     — 32 байта
+//   OpeningBookEntry[entryCount]          — по 24 байта, отсортированы
+//                                           по key, внутри одного key —
+//                                           от лучшего хода к худшему
+//
+// Ключ — канонический хеш позиции: позиция приводится к одной из 8
+// симметрий квадрата и сдвигается так, чтобы минимальные координаты
+// камней были (0, 0). Ход хранится в тех же канонических координатах.
+// Файл отображается в память и используется без разбора. Книга годится
+// только для той длины линии, с которой сыграны её партии (winLength).
+
+struct OpeningBookHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t maxPlies;
+    std::uint32_t winLength;
+    std::uint32_t reserved;
+    std::uint64_t entryCount;
+};
+
+struct OpeningBookEntry {
+    std::uint64_t key;
+    std::int32_t x;
+    std::int32_t y;
+    std::uint32_t plays;
+    std::int32_t score;     // сумма результатов: +1 победа, 0 ничья, -1 поражение
+};
+
+static_assert(sizeof(OpeningBookHeader) == 32, "unexpected book header size");
+static_assert(sizeof(OpeningBookEntry) == 24, "unexpected book entry size");
+
+// Каноническая форма позиции: ключ + преобразование, которым она получена
+struct CanonicalPosition {
+    std::uint64_t key;
+    int symmetry;
+    int offsetX;
+    int offsetY;
+};
+
+namespace book_detail {
+
+constexpr char kMagic[8] = { 'T', 'T', 'T', 'B', 'O', 'O', 'K', '1' };
+constexpr std::uint32_t kVersion = 2;
+
+// Симметрия s: бит 0 — отражение по x, бит 1 — по y, бит 2 — обмен осей
+inline Position Transform(const Position& p, int s) noexcept {
+    int u = (s & 4) ? p.y : p.x;
+    int v = (s & 4) ? p.x : p.y;
+    return Position((s & 1) ? -u : u, (s & 2) ? -v : v);
+}
+
+inline Position InverseTransform(const Position& p, int s) noexcept {
+    int u = (s & 1) ? -p.x : p.x;
+    int v = (s & 2) ? -p.y : p.y;
+    return (s & 4) ? Position(v, u) : Position(u, v);
+}
+
+} // namespace book_detail
+
+// Приводит позицию к каноническому виду. Ключ не зависит от порядка
+// камней, от сдвига позиции и от её поворотов/отражений.
+inline CanonicalPosition Canonicalize(const DynamicArray<Stone>& stones,
+                                      Cell player) {
+    CanonicalPosition best{0, 0, 0, 0};
+    bool first = true;
+
+    for (int s = 0; s < 8; ++s) {
+        int minX = 0;
+        int minY = 0;
+        for (std::size_t i = 0; i < stones.size(); ++i) {
+            Position t = book_detail::Transform(stones[i].pos, s);
+            if (i == 0 || t.x < minX) {
+                minX = t.x;
+            }
+            if (i == 0 || t.y < minY) {
+                minY = t.y;
+            }
+        }
+
+        // XOR делает ключ независимым от порядка обхода камней
+        std::uint64_t key = HashMix64(static_cast<std::uint64_t>(player));
+        for (std::size_t i = 0; i < stones.size(); ++i) {
+            Position t = book_detail::Transform(stones[i].pos, s);
+            key ^= StoneHash(t.x - minX, t.y - minY, stones[i].cell);
+        }
+
+        if (first || key < best.key) {
+            best = CanonicalPosition{key, s, minX, minY};
+            first = false;
+        }
+    }
+    return best;
+}
+
+// Перевод хода из канонических координат в координаты доски
+inline Position FromCanonical(const CanonicalPosition& canon,
+                              const Position& move) {
+    return book_detail::InverseTransform(
+        Position(move.x + canon.offsetX, move.y + canon.offsetY),
+        canon.symmetry);
+}
+
+inline Position ToCanonical(const CanonicalPosition& canon,
+                            const Position& move) {
+    Position t = book_detail::Transform(move, canon.symmetry);
+    return Position(t.x - canon.offsetX, t.y - canon.offsetY);
+}
+
+// Читатель книги: файл отображается в память только для чтения
+class OpeningBook {
+private:
+    MappedFile file_;
+    const OpeningBookEntry* entries_;
+    std::size_t entryCount_;
+    int maxPlies_;
+    int winLength_;
+    std::uint32_t minPlays_;
+
+public:
+    // Ход, сыгранный меньше чем в стольких партиях, — случайность,
+    // а не проверенный дебют
+    static constexpr std::uint32_t kDefaultMinPlays = 2;
+
+    OpeningBook()
+        : entries_(nullptr), entryCount_(0), maxPlies_(0), winLength_(0),
+          minPlays_(kDefaultMinPlays) {}
+
+    bool Open(const std::string& path) {
+        Close();
+        if (!file_.Open(path)) {
+            return false;
+        }
+
+        if (file_.Size() < sizeof(OpeningBookHeader)) {
+            Close();
+            return false;
+        }
+
+        // Число записей сверяется делением: произведение entryCount из
+        // файла на размер записи может переполниться и сойтись с размером
+        const auto* header =
+            reinterpret_cast<const OpeningBookHeader*>(file_.Data());
+        const std::size_t body = file_.Size() - sizeof(OpeningBookHeader);
+        if (std::memcmp(header->magic, book_detail::kMagic,
+                        sizeof(book_detail::kMagic)) != 0 ||
+            header->version != book_detail::kVersion ||
+            header->winLength == 0 ||
+            body % sizeof(OpeningBookEntry) != 0 ||
+            header->entryCount != body / sizeof(OpeningBookEntry)) {
+            Close();
+            return false;
+        }
+
+        entries_ = reinterpret_cast<const OpeningBookEntry*>(
+            file_.Data() + sizeof(OpeningBookHeader));
+        entryCount_ = static_cast<std::size_t>(header->entryCount);
+        maxPlies_ = static_cast<int>(header->maxPlies);
+        winLength_ = static_cast<int>(header->winLength);
+        return true;
+    }
+
+    void Close() {
+        file_.Close();
+        entries_ = nullptr;
+        entryCount_ = 0;
+        maxPlies_ = 0;
+        winLength_ = 0;
+    }
+
+    [[nodiscard]] bool IsOpen() const noexcept {
+        return file_.IsOpen();
+    }
+
+    [[nodiscard]] std::size_t GetEntryCount() const noexcept {
+        return entryCount_;
+    }
+
+    [[nodiscard]] int GetMaxPlies() const noexcept {
+        return maxPlies_;
+    }
+
+    // Длина линии, для которой построена книга (0 — книга не открыта)
+    [[nodiscard]] int GetWinLength() const noexcept {
+        return winLength_;
+    }
+
+    void SetMinPlays(std::uint32_t minPlays) noexcept {
+        minPlays_ = minPlays;
+    }
+
+    [[nodiscard]] std::uint32_t GetMinPlays() const noexcept {
+        return minPlays_;
+    }
+
+    // Лучший книжный ход для позиции или false, если позиции нет в книге
+    // либо лучший ход не выигрывал в среднем (score <= 0) или сыгран
+    // меньше чем в minPlays партиях — тогда решает поиск
+    bool Probe(const DynamicArray<Stone>& stones, Cell player,
+               Position& move) const {
+        if (entries_ == nullptr ||
+            stones.size() >= static_cast<std::size_t>(maxPlies_)) {
+            return false;
+        }
+
+        CanonicalPosition canon = Canonicalize(stones, player);
+
+        const OpeningBookEntry* end = entries_ + entryCount_;
+        const OpeningBookEntry* it = std::lower_bound(
+            entries_, end, canon.key,
+            [](const OpeningBookEntry& e, std::uint64_t key) {
+                return e.key < key;
+            }
+        );
+        if (it == end || it->key != canon.key) {
+            return false;
+        }
+
+        // Записи с одним ключом отсортированы от лучшей к худшей
+        if (it->score <= 0 || it->plays < minPlays_) {
+            return false;
+        }
+        move = FromCanonical(canon, Position(it->x, it->y));
+        return true;
+    }
+};
+
+// Построитель книги: накапливает ходы с результатами партий
+// и записывает отсортированный файл
+class OpeningBookBuilder {
+private:
+    DynamicArray<OpeningBookEntry> records_;
+
+    static bool ByKeyAndMove(const OpeningBookEntry& a,
+                             const OpeningBookEntry& b) {
+        if (a.key != b.key) {
+            return a.key < b.key;
+        }
+        return (a.x < b.x) || (a.x == b.x && a.y < b.y);
+    }
+
+    // Средний результат с априорной «ничьей» в одну партию,
+    // чтобы единственная случайная победа не вытесняла проверенный ход
+    static bool ByKeyAndQuality(const OpeningBookEntry& a,
+                                const OpeningBookEntry& b) {
+        if (a.key != b.key) {
+            return a.key < b.key;
+        }
+        std::int64_t lhs = static_cast<std::int64_t>(a.score) * (b.plays + 1);
+        std::int64_t rhs = static_cast<std::int64_t>(b.score) * (a.plays + 1);
+        if (lhs != rhs) {
+            return lhs > rhs;
+        }
+        return a.plays > b.plays;
+    }
+
+public:
+    // result: +1 — ходивший выиграл партию, 0 — ничья, -1 — проиграл
+    void Record(const DynamicArray<Stone>& stones, Cell player,
+                const Position& move, int result) {
+        CanonicalPosition canon = Canonicalize(stones, player);
+        Position m = ToCanonical(canon, move);
+
+        OpeningBookEntry entry{};
+        entry.key = canon.key;
+        entry.x = m.x;
+        entry.y = m.y;
+        entry.plays = 1;
+        entry.score = result;
+        records_.push_back(entry);
+    }
+
+    [[nodiscard]] std::size_t GetRecordCount() const noexcept {
+        return records_.size();
+    }
+
+    // winLength — длина линии, с которой сыграны записанные партии
+    bool Write(const std::string& path, int maxPlies, int winLength) {
+        if (winLength <= 0) {
+            return false;
+        }
+
+        // Сливаем одинаковые (позиция, ход)
+        std::sort(records_.begin(), records_.end(), ByKeyAndMove);
+
+        DynamicArray<OpeningBookEntry> merged;
+        for (const auto& r : records_) {
+            if (!merged.empty()) {
+                OpeningBookEntry& last = merged[merged.size() - 1];
+                if (last.key == r.key && last.x == r.x && last.y == r.y) {
+                    last.plays += r.plays;
+                    last.score += r.score;
+                    continue;
+                }
+            }
+            merged.push_back(r);
+        }
+
+        std::sort(merged.begin(), merged.end(), ByKeyAndQuality);
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            return false;
+        }
+
+        OpeningBookHeader header{};
+        std::memcpy(header.magic, book_detail::kMagic,
+                    sizeof(book_detail::kMagic));
+        header.version = book_detail::kVersion;
+        header.maxPlies = static_cast<std::uint32_t>(maxPlies);
+        header.winLength = static_cast<std::uint32_t>(winLength);
+        header.entryCount = merged.size();
+
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!merged.empty()) {
+            out.write(reinterpret_cast<const char*>(merged.begin()),
+                      static_cast<std::streamsize>(
+                          merged.size() * sizeof(OpeningBookEntry)));
+        }
+        return static_cast<bool>(out);
+    }
+};
@@ -0,0 +1,147 @@
+// Position.hpp
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct Position {
+    int x;
+    int y;
+
+    Position(int x_ = 0, int y_ = 0)
+        : x(x_), y(y_) {}
+
+    bool operator==(const Position& other) const noexcept {
+        return x == other.x && y == other.y;
+    }
+};
+
+enum Cell {
+    EMPTY = 0,
+    X = 1,
+    O = 2
+};
+
+// Камень на доске: координаты + цвет
+struct Stone {
+    Position pos;
+    Cell cell;
+
+    Stone(Position p = Position(), Cell c = EMPTY)
+        : pos(p), cell(c) {}
+};
+
+// Перемешивание 64-битного значения (финализатор splitmix64)
+inline std::uint64_t HashMix64(std::uint64_t v) noexcept {
+    v ^= v >> 30;
+    v *= 0xbf58476d1ce4e5b9ULL;
+    v ^= v >> 27;
+    v *= 0x94d049bb133111ebULL;
+    v ^= v >> 31;
+    return v;
+}
+
+// Перемешивание 32-битного значения (lowbias32)
+inline std::uint32_t HashMix32(std::uint32_t v) noexcept {
+    v ^= v >> 16;
+    v *= 0x7feb352dU;
+    v ^= v >> 15;
+    v *= 0x846ca68bU;
+    v ^= v >> 16;
+    return v;
+}
+
+// Хеш-функция для Position: обе координаты целиком в 64 битах,
+// затем перемешивание — без переполнения на любых int
+struct PositionHash {
+    std::size_t operator()(const Position& pos) const noexcept {
+        std::uint64_t packed =
+            (static_cast<std::uint64_t>(static_cast<std::uint32_t>(pos.x)) << 32) |
+            static_cast<std::uint32_t>(pos.y);
+        return static_cast<std::size_t>(HashMix64(packed));
+    }
+};
+
+// Упакованные координаты: по 15 бит на x и y со смещением, всего 30 бит.
+// Поле ограничено квадратом [kMinCoord, kMaxCoord] по обеим осям —
+// TicTacToeGame::MakeMove отклоняет ходы за его пределами.
+constexpr int kCoordBits = 15;
+constexpr int kMinCoord = -(1 << (kCoordBits - 1));
+constexpr int kMaxCoord = (1 << (kCoordBits - 1)) - 1;
+
+[[nodiscard]] inline bool IsValidCoord(int x, int y) noexcept {
+    // Сдвиг в беззнаковые: одно сравнение на ось и без переполнения int
+    const std::uint32_t bias = static_cast<std::uint32_t>(kMinCoord);
+    const std::uint32_t span = static_cast<std::uint32_t>(kMaxCoord - kMinCoord);
+    return static_cast<std::uint32_t>(x) - bias <= span &&
+           static_cast<std::uint32_t>(y) - bias <= span;
+}
+
+// Прямоугольник поля, границы включительно. По умолчанию — всё
+// допустимое поле; Contains(x, y) влечёт IsValidCoord(x, y).
+struct BoardBounds {
+    int minX = kMinCoord;
+    int minY = kMinCoord;
+    int maxX = kMaxCoord;
+    int maxY = kMaxCoord;
+
+    [[nodiscard]] bool Contains(int x, int y) const noexcept {
+        return x >= minX && x <= maxX && y >= minY && y <= maxY;
+    }
+
+    [[nodiscard]] Position Center() const noexcept {
+        // Для поля по умолчанию — (0, 0), как на бесконечной доске
+        return Position((minX + maxX) / 2, (minY + maxY) / 2);
+    }
+};
+
+struct PackedPosition {
+    std::uint32_t key;
+
+    explicit PackedPosition(std::uint32_t key_ = 0)
+        : key(key_) {}
+
+    // Координаты должны проходить IsValidCoord
+    static PackedPosition Pack(int x, int y) noexcept {
+        return PackedPosition(
+            (static_cast<std::uint32_t>(x - kMinCoord) << kCoordBits) |
+            static_cast<std::uint32_t>(y - kMinCoord));
+    }
+
+    [[nodiscard]] Position Unpack() const noexcept {
+        const std::uint32_t mask = (1U << kCoordBits) - 1;
+        return Position(static_cast<int>(key >> kCoordBits) + kMinCoord,
+                        static_cast<int>(key & mask) + kMinCoord);
+    }
+
+    bool operator==(const PackedPosition& other) const noexcept {
+        return key == other.key;
+    }
+};
+
+struct PackedPositionHash {
+    std::size_t operator()(const PackedPosition& pos) const noexcept {
+        return HashMix32(pos.key);
+    }
+};
+
+// Клетка доски одним 32-битным словом: ключ координат << 2 | цвет.
+// У занятой клетки цвет не EMPTY, поэтому слово 0 — «пусто».
+[[nodiscard]] inline std::uint32_t PackCell(PackedPosition pos,
+                                            Cell cell) noexcept {
+    return (pos.key << 2) | static_cast<std::uint32_t>(cell);
+}
+
+[[nodiscard]] inline Cell UnpackCell(std::uint32_t word) noexcept {
+    return static_cast<Cell>(word & 3U);
+}
+
+// Zobrist-подобный ключ камня для бесконечного поля: вместо таблицы
+// случайных чисел — перемешанные координаты. Ключ позиции — XOR ключей
+// всех камней, поэтому он обновляется за O(1) при ходе и отмене хода.
+inline std::uint64_t StoneHash(int x, int y, Cell cell) noexcept {
+    std::uint64_t packed =
+        (static_cast<std::uint64_t>(static_cast<std::uint32_t>(x)) << 32) |
+        static_cast<std::uint32_t>(y);
+    return HashMix64(packed * 3 + static_cast<std::uint64_t>(cell));
+}
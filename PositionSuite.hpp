@@ -0,0 +1,66 @@
+// PositionSuite.hpp
+#pragma once
+
+#include "TicTacToe.hpp"
+#include "DynamicArray.hpp"
+
+#include <sstream>
+#include <string>
+
+// Текстовая запись партии: ходы "x,y" через пробел, первым ходит X,
+// дальше цвета чередуются. Например: "0,0 1,0 0,1 1,1".
+inline bool ParseMoveList(const std::string& text,
+                          DynamicArray<Position>& moves) {
+    moves.clear();
+    std::istringstream in(text);
+    std::string token;
+    while (in >> token) {
+        std::size_t comma = token.find(',');
+        if (comma == std::string::npos) {
+            return false;
+        }
+        try {
+            moves.push_back(Position(std::stoi(token.substr(0, comma)),
+                                     std::stoi(token.substr(comma + 1))));
+        } catch (...) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Расставляет ходы на доске; возвращает, чей теперь ход,
+// или EMPTY, если какой-то ход попал в занятую клетку
+template<int WinLength>
+inline Cell PlayMoveList(BasicTicTacToeGame<WinLength>& game,
+                         const DynamicArray<Position>& moves) {
+    Cell player = X;
+    for (const auto& m : moves) {
+        if (!game.MakeMove(m.x, m.y, player)) {
+            return EMPTY;
+        }
+        player = (player == X) ? O : X;
+    }
+    return player;
+}
+
+// Фиксированный набор позиций для бенчмарков и регрессионных тестов
+struct SuitePosition {
+    const char* name;
+    const char* moves;
+};
+
+inline const SuitePosition* GetPositionSuite(std::size_t& count) {
+    static const SuitePosition suite[] = {
+        // Позиция из compareAlgorithms
+        { "compare",    "0,0 1,0 0,1 1,1" },
+        { "opening",    "0,0 1,1 -1,1 0,1 1,-1" },
+        { "threat",     "0,0 0,1 1,0 1,1 2,0 -1,-1 3,0" },
+        { "middlegame", "0,0 1,0 1,1 2,2 0,1 0,2 -1,2 -1,0 2,-1 3,-2 "
+                        "1,-1 -1,1" },
+        { "crowded",    "0,0 1,0 1,1 2,2 0,1 0,2 -1,2 -1,0 2,-1 3,-2 "
+                        "1,-1 -1,1 2,0 3,0 -2,3 -2,-1 0,-1 4,-3" },
+    };
+    count = sizeof(suite) / sizeof(suite[0]);
+    return suite;
+}
@@ -0,0 +1,706 @@
+// SearchState.hpp
+#pragma once
+
+#include "Position.hpp"
+#include "HashTable.hpp"
+#include "DynamicArray.hpp"
+#include "NnueNetwork.hpp"
+#include "EvalWeights.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// Состояние доски для поиска.
+//
+// Доска копируется из HashTable один раз перед поиском (Load), дальше
+// поиск работает только с заранее выделенной памятью:
+//   - камни лежат в таблице с открытой адресацией (загрузка <= 25%),
+//     клетка — одно 32-битное слово PackCell, 16 клеток на линию кэша;
+//   - MakeMove/UndoMove — стек: отменяется всегда последний ход, поэтому
+//     его ячейку можно просто очистить, ни одна цепочка проб через неё
+//     не проходит;
+//   - у каждого уровня (ply) свой буфер кандидатов.
+// После Load ни MakeMove/UndoMove, ни GenerateMoves, ни оценка
+// не обращаются к куче, пока поиск не выходит за maxPly из Load.
+// С сетью (SetNetwork) у каждого хода стека свой аккумулятор сети:
+// MakeMove обновляет копию верхнего, UndoMove снимает его. Так же по
+// стеку запоминаются флаги собранных линий (HasLine): линия на доске
+// либо была на уровне, где флаги уже известны, либо проходит через
+// камень, поставленный позже, — поэтому достаточно CheckWinAt по этим
+// камням. Флаги и суммы линий считаются только по запросу: поиск, не
+// спрашивающий о них (MCTS, сеть), за них не платит.
+//
+// Evaluate считает по ступеням, результат всегда тот же, что у полного
+// обхода:
+//   1) собранная линия — по флагам, за O(1), сразу ±winScore;
+//   2) сумма линий уже посчитана на уровне родителя (предыдущий ход
+//      стека) — к ней прибавляется изменение от последнего камня
+//      (LineDelta: четыре прямые через камень, а не вся доска);
+//   3) иначе — полный обход линий всех камней; заодно через LineDelta
+//      запоминается сумма родителя, так что соседние листья того же
+//      узла идут по ступени 2.
+class SearchState {
+private:
+    DynamicArray<std::uint32_t> slots_;       // PackCell или 0 — пусто
+    std::size_t mask_;
+    DynamicArray<Stone> stones_;              // хвост — стек ходов поиска
+    DynamicArray<std::size_t> stoneSlots_;    // ячейка каждого камня
+    DynamicArray<DynamicArray<Position>> plyMoves_;
+    std::size_t stoneCapacity_;
+    std::uint64_t hash_;
+    int winLength_;
+    BoardBounds bounds_;
+    EvalWeights weights_;
+    const NnueNetwork* net_;                  // не владеем, может быть nullptr
+    DynamicArray<NnueAccumulator> accumulators_;  // [0] — до камней
+
+    // Уровень стека ходов: [0] — до камней, [i] — после i-го камня
+    struct Level {
+        int score = 0;            // сумма линий за X, если scored
+        bool scored = false;
+        std::uint8_t lines = 0;   // LineBit собранных линий, если linesKnown
+        bool linesKnown = false;
+    };
+    // Флаги и суммы — кэш HasLine и Evaluate, поэтому mutable
+    mutable DynamicArray<Level> levels_;
+
+    [[nodiscard]] std::size_t FindSlot(PackedPosition key) const {
+        std::size_t i = HashMix32(key.key) & mask_;
+        while (slots_[i] != 0 && (slots_[i] >> 2) != key.key) {
+            i = (i + 1) & mask_;
+        }
+        return i;
+    }
+
+    void Insert(const Position& pos, Cell cell) {
+        PackedPosition key = PackedPosition::Pack(pos.x, pos.y);
+        std::size_t i = FindSlot(key);
+        if (net_ != nullptr) {
+            // Окна считаются по доске до хода: клетка ещё пуста
+            NnueAccumulator next = accumulators_[accumulators_.size() - 1];
+            net_->AddStone(next, pos, cell,
+                           [this](int x, int y) { return At(x, y); });
+            accumulators_.push_back(next);
+        }
+        slots_[i] = PackCell(key, cell);
+        levels_.push_back(Level());
+        stones_.push_back(Stone(pos, cell));
+        stoneSlots_.push_back(i);
+        hash_ ^= StoneHash(pos.x, pos.y, cell);
+    }
+
+    // Память под stones камней и plies уровней поиска; растёт только вверх
+    void EnsureCapacity(std::size_t stones, std::size_t plies) {
+        if (stones > stoneCapacity_) {
+            std::size_t capacity = 32;
+            while (capacity < stones) {
+                capacity <<= 1;
+            }
+            stoneCapacity_ = capacity;
+
+            slots_ = DynamicArray<std::uint32_t>(capacity * 4);
+            for (std::size_t i = 0; i < capacity * 4; ++i) {
+                slots_.push_back(0);
+            }
+            mask_ = capacity * 4 - 1;
+
+            stones_.reserve(capacity);
+            stoneSlots_.reserve(capacity);
+            levels_.reserve(capacity + 1);
+            if (net_ != nullptr) {
+                accumulators_.reserve(capacity + 1);
+            }
+            for (auto& buffer : plyMoves_) {
+                buffer.reserve(capacity * 8 + 1);
+            }
+        }
+
+        while (plyMoves_.size() < plies) {
+            DynamicArray<Position> buffer(stoneCapacity_ * 8 + 1);
+            plyMoves_.push_back(std::move(buffer));
+        }
+    }
+
+    void Prepare(std::size_t stones, int winLength, int maxPly,
+                 const BoardBounds& bounds) {
+        winLength_ = winLength;
+        bounds_ = bounds;
+        std::size_t plies = static_cast<std::size_t>(maxPly < 1 ? 1 : maxPly);
+        EnsureCapacity(stones + plies, plies);
+
+        for (auto& slot : slots_) {
+            slot = 0;
+        }
+        stones_.clear();
+        stoneSlots_.clear();
+        hash_ = 0;
+        ResetStacks();
+    }
+
+    // Стеки по ходам (уровни, аккумуляторы) — к пустой доске
+    void ResetStacks() {
+        levels_.clear();
+        levels_.push_back(EmptyLevel());
+        accumulators_.clear();
+        if (net_ != nullptr) {
+            NnueAccumulator empty;
+            net_->Reset(empty);
+            accumulators_.push_back(empty);
+        }
+    }
+
+    // Заново вставить камни в том же порядке (после роста таблицы или
+    // смены сети)
+    void Rebuild() {
+        DynamicArray<Stone> saved(stones_);
+        for (auto& slot : slots_) {
+            slot = 0;
+        }
+        stones_.clear();
+        stoneSlots_.clear();
+        hash_ = 0;
+        ResetStacks();
+        for (const auto& s : saved) {
+            Insert(s.pos, s.cell);
+        }
+    }
+
+    // Перестроить таблицу после роста (камни сохраняются)
+    void Grow(std::size_t stones) {
+        stoneCapacity_ = 0;
+        EnsureCapacity(stones, plyMoves_.size());
+        Rebuild();
+    }
+
+public:
+    SearchState()
+        : slots_(), mask_(0), stones_(), stoneSlots_(), plyMoves_(),
+          stoneCapacity_(0), hash_(0), winLength_(5), bounds_(),
+          weights_(), net_(nullptr), accumulators_(), levels_() {
+        levels_.push_back(EmptyLevel());
+    }
+
+    // Веса Evaluate; переживают Load
+    void SetEvalWeights(const EvalWeights& weights) {
+        weights_ = weights;
+        for (auto& level : levels_) {
+            level.scored = false;
+        }
+    }
+
+    [[nodiscard]] const EvalWeights& GetEvalWeights() const noexcept {
+        return weights_;
+    }
+
+    // Сеть для EvaluateNnue (nullptr — без сети); её длина линии должна
+    // совпадать с winLength из Load. Аккумуляторы текущих камней
+    // пересчитываются сразу.
+    void SetNetwork(const NnueNetwork* net) {
+        net_ = net;
+        if (net_ != nullptr) {
+            accumulators_.reserve(stoneCapacity_ + 1);
+        }
+        Rebuild();
+    }
+
+    [[nodiscard]] const NnueNetwork* GetNetwork() const noexcept {
+        return net_;
+    }
+
+    // Копирует доску (все камни в пределах bounds); maxPly — сколько
+    // уровней поиска будет сделано
+    void Load(const HashTable<Position, Cell>& board, int winLength,
+              int maxPly, const BoardBounds& bounds = BoardBounds()) {
+        Prepare(board.GetCount(), winLength, maxPly, bounds);
+        board.ForEach([this](const Position& pos, Cell cell) {
+            Insert(pos, cell);
+        });
+        // Флаги линий загруженной позиции — один раз, а не в каждом
+        // узле поиска
+        (void)Lines();
+    }
+
+    // То же из списка камней (например, копии доски из GetStones)
+    void Load(const DynamicArray<Stone>& stones, int winLength, int maxPly,
+              const BoardBounds& bounds = BoardBounds()) {
+        Prepare(stones.size(), winLength, maxPly, bounds);
+        for (const auto& s : stones) {
+            Insert(s.pos, s.cell);
+        }
+        (void)Lines();
+    }
+
+    // За пределами поля клетки пусты, как и раньше на бесконечной доске
+    [[nodiscard]] Cell At(int x, int y) const {
+        if (!IsValidCoord(x, y)) {
+            return EMPTY;
+        }
+        return UnpackCell(slots_[FindSlot(PackedPosition::Pack(x, y))]);
+    }
+
+    // pos должна проходить IsValidCoord
+    void MakeMove(const Position& pos, Cell cell) {
+        if (stones_.size() >= stoneCapacity_) {
+            Grow(stones_.size() + 1);
+        }
+        Insert(pos, cell);
+    }
+
+    void UndoMove() {
+        std::size_t last = stones_.size() - 1;
+        const Stone& s = stones_[last];
+        slots_[stoneSlots_[last]] = 0;
+        hash_ ^= StoneHash(s.pos.x, s.pos.y, s.cell);
+        stones_.pop_back();
+        stoneSlots_.pop_back();
+        levels_.pop_back();
+        if (net_ != nullptr) {
+            accumulators_.pop_back();
+        }
+    }
+
+    [[nodiscard]] std::size_t GetStoneCount() const noexcept {
+        return stones_.size();
+    }
+
+    [[nodiscard]] const DynamicArray<Stone>& GetStones() const noexcept {
+        return stones_;
+    }
+
+    // Ключ позиции: XOR StoneHash всех камней
+    [[nodiscard]] std::uint64_t Hash() const noexcept {
+        return hash_;
+    }
+
+    [[nodiscard]] int GetWinLength() const noexcept {
+        return winLength_;
+    }
+
+    [[nodiscard]] const BoardBounds& GetBounds() const noexcept {
+        return bounds_;
+    }
+
+    // Кандидаты — пустые клетки рядом с камнями в пределах bounds из
+    // Load, без повторов, в порядке (x, y); на пустой доске — центр поля. Результат живёт в буфере уровня ply.
+    const DynamicArray<Position>& GenerateMoves(std::size_t ply) {
+        if (ply >= plyMoves_.size()) {
+            EnsureCapacity(stoneCapacity_, ply + 1);
+        }
+        DynamicArray<Position>& candidates = plyMoves_[ply];
+        candidates.clear();
+
+        if (stones_.empty()) {
+            candidates.push_back(bounds_.Center());
+            return candidates;
+        }
+
+        for (const auto& s : stones_) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                for (int dy = -1; dy <= 1; ++dy) {
+                    if (dx == 0 && dy == 0) {
+                        continue;
+                    }
+                    Position p(s.pos.x + dx, s.pos.y + dy);
+                    if (bounds_.Contains(p.x, p.y) && At(p.x, p.y) == EMPTY) {
+                        candidates.push_back(p);
+                    }
+                }
+            }
+        }
+
+        if (candidates.empty()) {
+            return candidates;
+        }
+
+        std::sort(
+            candidates.begin(),
+            candidates.end(),
+            [](const Position& a, const Position& b) {
+                return (a.x < b.x) || (a.x == b.x && a.y < b.y);
+            }
+        );
+
+        auto uniqueEnd = std::unique(candidates.begin(), candidates.end());
+        std::size_t newSize =
+            static_cast<std::size_t>(uniqueEnd - candidates.begin());
+        while (candidates.size() > newSize) {
+            candidates.pop_back();
+        }
+        return candidates;
+    }
+
+    // Проверки длины линии по winLength_: для частых длин — ядра
+    // с длиной-константой, для остальных — общее ядро
+    [[nodiscard]] bool CheckWin(Cell player) const {
+        switch (winLength_) {
+            case 3: return CheckWinFixed<3>(player);
+            case 4: return CheckWinFixed<4>(player);
+            case 5: return CheckWinFixed<5>(player);
+            case 6: return CheckWinFixed<6>(player);
+            default: return CheckWinFixed<0>(player);
+        }
+    }
+
+    // Замкнул ли камень player в pos линию: смотрим только четыре
+    // линии через pos, а не всю доску — для проверки после хода
+    [[nodiscard]] bool CheckWinAt(const Position& pos, Cell player) const {
+        for (int d = 0; d < 4; ++d) {
+            int count = 1;
+            for (int dir = -1; dir <= 1; dir += 2) {
+                const int dx = kDirections[d][0] * dir;
+                const int dy = kDirections[d][1] * dir;
+                int nx = pos.x + dx;
+                int ny = pos.y + dy;
+                while (count < winLength_ && At(nx, ny) == player) {
+                    ++count;
+                    nx += dx;
+                    ny += dy;
+                }
+            }
+            if (count >= winLength_) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Собрана ли линия player; всегда совпадает с CheckWin. По флагам
+    // стека ходов: обычно это один CheckWinAt по последнему камню, а не
+    // обход всей доски
+    [[nodiscard]] bool HasLine(Cell player) const {
+        return (Lines() & LineBit(player)) != 0;
+    }
+
+    // Аккумулятор сети для текущей позиции; только с SetNetwork
+    [[nodiscard]] const NnueAccumulator& GetAccumulator() const {
+        return accumulators_[accumulators_.size() - 1];
+    }
+
+    // Собрана ли линия player — по счётчику окон аккумулятора, без
+    // обхода доски; только с SetNetwork
+    [[nodiscard]] bool CheckWinNnue(Cell player) const {
+        return GetAccumulator().completed[player == X ? 0 : 1] > 0;
+    }
+
+    // Оценка сетью: при собранной линии — ±kWinScore, как у Evaluate,
+    // иначе выход сети; только с SetNetwork
+    [[nodiscard]] int EvaluateNnue(Cell player) const {
+        const NnueAccumulator& acc = GetAccumulator();
+        if (acc.completed[0] > 0) {
+            return (player == X) ? NnueNetwork::kWinScore
+                                 : -NnueNetwork::kWinScore;
+        }
+        if (acc.completed[1] > 0) {
+            return (player == O) ? NnueNetwork::kWinScore
+                                 : -NnueNetwork::kWinScore;
+        }
+        return net_->Evaluate(acc, player);
+    }
+
+    // Та же оценка, что и TicTacToeGame::EvaluatePosition
+    [[nodiscard]] int Evaluate(Cell player) const {
+        switch (winLength_) {
+            case 3: return EvaluateFixed<3>(player);
+            case 4: return EvaluateFixed<4>(player);
+            case 5: return EvaluateFixed<5>(player);
+            case 6: return EvaluateFixed<6>(player);
+            default: return EvaluateFixed<0>(player);
+        }
+    }
+
+    // Ядра проверки и оценки. WinLength > 0 должна совпадать с
+    // GetWinLength(): тогда длины всех сканов — константы и циклы
+    // разворачиваются. WinLength = 0 — длина берётся из winLength_.
+    template<int WinLength>
+    [[nodiscard]] bool CheckWinFixed(Cell player) const {
+        static_assert(WinLength >= 0, "WinLength must be non-negative");
+        const int winLength = WinLength > 0 ? WinLength : winLength_;
+
+        for (const auto& s : stones_) {
+            if (s.cell != player) {
+                continue;
+            }
+
+            for (int d = 0; d < 4; ++d) {
+                const int dx = kDirections[d][0];
+                const int dy = kDirections[d][1];
+
+                // Линию считаем только от её начала: если сзади свой
+                // камень, эту линию проверит камень, с которого она идёт
+                if (At(s.pos.x - dx, s.pos.y - dy) == player) {
+                    continue;
+                }
+
+                int count = 1;
+                int nx = s.pos.x + dx;
+                int ny = s.pos.y + dy;
+                while (count < winLength && At(nx, ny) == player) {
+                    ++count;
+                    nx += dx;
+                    ny += dy;
+                }
+
+                if (count >= winLength) {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    template<int WinLength>
+    [[nodiscard]] int EvaluateFixed(Cell player) const {
+        static_assert(WinLength >= 0, "WinLength must be non-negative");
+
+        if (HasLine(X)) {
+            return (player == X) ? weights_.winScore : -weights_.winScore;
+        }
+        if (HasLine(O)) {
+            return (player == O) ? weights_.winScore : -weights_.winScore;
+        }
+
+        const int score = LineSum<WinLength>();
+        return (player == X) ? score : -score;
+    }
+
+    // Та же оценка полным обходом доски, без флагов и запомненных сумм
+    // (эталон для ступеней Evaluate и бенчмарка ядра)
+    template<int WinLength>
+    [[nodiscard]] int EvaluateScanFixed(Cell player) const {
+        if (CheckWinFixed<WinLength>(X)) {
+            return (player == X) ? weights_.winScore : -weights_.winScore;
+        }
+        if (CheckWinFixed<WinLength>(O)) {
+            return (player == O) ? weights_.winScore : -weights_.winScore;
+        }
+
+        int score = 0;
+        ForEachLine<WinLength>([this, player, &score](Cell cell, int count) {
+            int lineScore = LineScore<WinLength>(count);
+            score += (cell == player) ? lineScore : -lineScore;
+        });
+        return score;
+    }
+
+    // Признаки оценки для подбора весов: counts[c] — число линий из c
+    // камней player минус число таких линий соперника, c < size. Оценка
+    // позиции без собранной линии — сумма counts[c] * lineScores[c].
+    void CountLines(Cell player, int* counts, int size) const {
+        for (int c = 0; c < size; ++c) {
+            counts[c] = 0;
+        }
+        ForEachLine<0>([player, counts, size](Cell cell, int count) {
+            if (count < size) {
+                counts[count] += (cell == player) ? 1 : -1;
+            }
+        });
+    }
+
+private:
+    [[nodiscard]] static Level EmptyLevel() noexcept {
+        Level level;
+        level.scored = true;
+        level.linesKnown = true;
+        return level;
+    }
+
+    // LineBit линий на доске: флаги ближайшего известного уровня ниже
+    // плюс CheckWinAt по камням, поставленным после него. Запоминаются
+    // только для верхнего уровня — промежуточные уровни видели доску без
+    // последующих камней.
+    [[nodiscard]] std::uint8_t Lines() const {
+        const std::size_t top = levels_.size() - 1;
+        if (!levels_[top].linesKnown) {
+            std::size_t known = top;
+            while (!levels_[known].linesKnown) {
+                --known;
+            }
+            std::uint8_t lines = levels_[known].lines;
+            for (std::size_t i = known; i < top; ++i) {
+                if (CheckWinAt(stones_[i].pos, stones_[i].cell)) {
+                    lines |= LineBit(stones_[i].cell);
+                }
+            }
+            levels_[top].lines = lines;
+            levels_[top].linesKnown = true;
+        }
+        return levels_[top].lines;
+    }
+
+    // Для более длинных линий ступени 2 нет: прямая не влезает в буфер
+    static constexpr int kMaxDeltaWinLength = 16;
+
+    // Сумма линий за X на верхнем уровне стека (ступени 2 и 3 Evaluate)
+    template<int WinLength>
+    [[nodiscard]] int LineSum() const {
+        const std::size_t top = levels_.size() - 1;
+        if (levels_[top].scored) {
+            return levels_[top].score;
+        }
+
+        const int winLength = WinLength > 0 ? WinLength : winLength_;
+        const bool delta = top > 0 && winLength <= kMaxDeltaWinLength;
+        int score;
+        if (delta && levels_[top - 1].scored) {
+            const Stone& last = stones_[stones_.size() - 1];
+            score = levels_[top - 1].score +
+                    LineDelta<WinLength>(last.pos, last.cell);
+        } else {
+            score = 0;
+            ForEachLine<WinLength>([this, &score](Cell cell, int count) {
+                int lineScore = LineScore<WinLength>(count);
+                score += (cell == X) ? lineScore : -lineScore;
+            });
+            if (delta) {
+                const Stone& last = stones_[stones_.size() - 1];
+                levels_[top - 1].score =
+                    score - LineDelta<WinLength>(last.pos, last.cell);
+                levels_[top - 1].scored = true;
+            }
+        }
+        levels_[top].score = score;
+        levels_[top].scored = true;
+        return score;
+    }
+
+    // Насколько камень cell в pos изменил сумму линий за X. Меняются
+    // линии самого камня и линии камней на тех же четырёх прямых не
+    // дальше winLength - 1 (дальше их скан не достаёт); всё это лежит
+    // в 4 * winLength - 3 клетках прямой вокруг pos, которые читаются
+    // не больше одного раза. Суммы до и после хода считаются по этому
+    // буферу так же, как в ForEachLine.
+    template<int WinLength>
+    [[nodiscard]] int LineDelta(const Position& pos, Cell cell) const {
+        const int winLength = WinLength > 0 ? WinLength : winLength_;
+        const int center = 2 * winLength - 2;
+        Cell line[4 * kMaxDeltaWinLength - 3];
+
+        auto lineValue = [&](int at) {
+            const Cell own = line[at];
+            int count = 1;
+            int empty = 0;
+            for (int dir = -1; dir <= 1; dir += 2) {
+                for (int step = 1; step < winLength; ++step) {
+                    Cell c = line[at + dir * step];
+                    if (c == own) {
+                        ++count;
+                    } else if (c == EMPTY) {
+                        ++empty;
+                    } else {
+                        break;
+                    }
+                }
+            }
+            if (count + empty < winLength) {
+                return 0;
+            }
+            int lineScore = LineScore<WinLength>(count);
+            return (own == X) ? lineScore : -lineScore;
+        };
+        auto neighbours = [&]() {
+            int sum = 0;
+            for (int at = center - winLength + 1; at < center + winLength;
+                 ++at) {
+                if (at != center && line[at] != EMPTY) {
+                    sum += lineValue(at);
+                }
+            }
+            return sum;
+        };
+
+        int delta = 0;
+        for (int d = 0; d < 4; ++d) {
+            const int dx = kDirections[d][0];
+            const int dy = kDirections[d][1];
+            auto read = [&](int i) {
+                line[i] = At(pos.x + dx * (i - center),
+                             pos.y + dy * (i - center));
+                return line[i] != EMPTY;
+            };
+            // Без соседей ближе winLength меняется только линия камня,
+            // а ей хватает ближних клеток
+            bool neighbour = false;
+            for (int i = center - winLength + 1; i < center + winLength;
+                 ++i) {
+                if (i != center && read(i)) {
+                    neighbour = true;
+                }
+            }
+            line[center] = cell;
+            if (!neighbour) {
+                delta += lineValue(center);
+                continue;
+            }
+            for (int i = 0; i <= center - winLength; ++i) {
+                read(i);
+                read(2 * center - i);
+            }
+            line[center] = EMPTY;
+            delta -= neighbours();
+            line[center] = cell;
+            delta += neighbours() + lineValue(center);
+        }
+        return delta;
+    }
+
+    // Линии, которые считает оценка: для каждого камня и направления —
+    // свои камни в пределах winLength - 1 клеток в обе стороны до
+    // чужого камня; линия учитывается, если в ней хватает места на
+    // выигрыш. func(cell, count) — цвет камня и число своих камней.
+    template<int WinLength, typename Func>
+    void ForEachLine(Func&& func) const {
+        const int winLength = WinLength > 0 ? WinLength : winLength_;
+
+        for (const auto& s : stones_) {
+            for (int d = 0; d < 4; ++d) {
+                int count = 1;
+                int empty = 0;
+
+                for (int dir = -1; dir <= 1; dir += 2) {
+                    const int dx = kDirections[d][0] * dir;
+                    const int dy = kDirections[d][1] * dir;
+                    int nx = s.pos.x + dx;
+                    int ny = s.pos.y + dy;
+
+                    for (int step = 0; step < winLength - 1; ++step) {
+                        Cell c = At(nx, ny);
+                        if (c == s.cell) {
+                            ++count;
+                        } else if (c == EMPTY) {
+                            ++empty;
+                        } else {
+                            break;
+                        }
+                        nx += dx;
+                        ny += dy;
+                    }
+                }
+
+                if (count + empty >= winLength) {
+                    func(s.cell, count);
+                }
+            }
+        }
+    }
+
+    [[nodiscard]] static std::uint8_t LineBit(Cell player) noexcept {
+        return player == X ? 1 : player == O ? 2 : 0;
+    }
+
+    static constexpr int kDirections[4][2] = {
+        {1, 0}, {0, 1}, {1, 1}, {1, -1}
+    };
+
+    // Очки линии из count своих камней (count < 2 * winLength); для
+    // длины-константы граница таблицы известна при компиляции
+    template<int WinLength>
+    [[nodiscard]] int LineScore(int count) const noexcept {
+        if constexpr (WinLength > 0 &&
+                      2 * WinLength <= EvalWeights::kMaxLineCount) {
+            return weights_.lineScores[count];
+        } else {
+            return weights_.LineScore(count);
+        }
+    }
+};
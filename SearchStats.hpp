@@ -0,0 +1,123 @@
+// SearchStats.hpp
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <ostream>
+
+// Сбор статистики поиска включён по умолчанию. Сборка с
+// -DTTT_SEARCH_STATS=0 превращает все счётчики и таймеры в пустые
+// операции, которые компилятор выбрасывает; поля тогда остаются нулями.
+#ifndef TTT_SEARCH_STATS
+#define TTT_SEARCH_STATS 1
+#endif
+
+// Статистика одного вызова FindBestMove
+struct SearchStats {
+    static constexpr bool kEnabled = TTT_SEARCH_STATS != 0;
+    static constexpr std::size_t kMaxPly = 32;
+
+    int depth = 0;
+    long long nodesPerPly[kMaxPly] = {};   // узлы по уровням, 0 — корень
+    long long nodes = 0;                   // все узлы дерева, с корнем
+    long long leafEvaluations = 0;         // вызовы оценки в листьях
+    long long ttHits = 0;                  // узлы, закрытые таблицей
+    long long cutoffs = 0;                 // узлы с отсечением
+    long long firstMoveCutoffs = 0;        // ... уже на первом ходе
+    long long moveGenNs = 0;
+    long long evalNs = 0;
+    long long winCheckNs = 0;
+    long long totalNs = 0;
+
+    void Clear() {
+        *this = SearchStats();
+    }
+
+    void OnNode(std::size_t ply) {
+        if constexpr (kEnabled) {
+            ++nodes;
+            ++nodesPerPly[ply < kMaxPly ? ply : kMaxPly - 1];
+        }
+    }
+
+    void OnLeaf() {
+        if constexpr (kEnabled) {
+            ++leafEvaluations;
+        }
+    }
+
+    void OnTTHit() {
+        if constexpr (kEnabled) {
+            ++ttHits;
+        }
+    }
+
+    // moveIndex — номер хода, на котором сработало отсечение
+    void OnCutoff(std::size_t moveIndex) {
+        if constexpr (kEnabled) {
+            ++cutoffs;
+            if (moveIndex == 0) {
+                ++firstMoveCutoffs;
+            }
+        }
+    }
+
+    // Доля отсечений, случившихся на первом ходе: мера качества
+    // упорядочивания ходов
+    [[nodiscard]] double FirstMoveCutoffRate() const {
+        return cutoffs > 0
+            ? static_cast<double>(firstMoveCutoffs) / static_cast<double>(cutoffs)
+            : 0.0;
+    }
+
+    // Эффективный коэффициент ветвления: корень степени depth из числа
+    // узлов на самом глубоком уровне
+    [[nodiscard]] double EffectiveBranchingFactor() const {
+        std::size_t last = static_cast<std::size_t>(depth);
+        if (depth <= 0 || last >= kMaxPly || nodesPerPly[last] == 0) {
+            return 0.0;
+        }
+        return std::pow(static_cast<double>(nodesPerPly[last]), 1.0 / depth);
+    }
+
+    static void WriteCsvHeader(std::ostream& out) {
+        out << "Узлов дерева,Листьев,Попаданий в таблицу,Отсечений,"
+               "Доля отсечений первым ходом,Эфф. ветвление,"
+               "Генерация ходов(мс),Оценка(мс),Проверка победы(мс)";
+    }
+
+    void WriteCsvRow(std::ostream& out) const {
+        out << nodes << ',' << leafEvaluations << ',' << ttHits << ','
+            << cutoffs << ',' << FirstMoveCutoffRate() << ','
+            << EffectiveBranchingFactor() << ',' << moveGenNs / 1e6 << ','
+            << evalNs / 1e6 << ',' << winCheckNs / 1e6;
+    }
+};
+
+// Прибавляет время жизни объекта к счётчику наносекунд
+class SearchStatsTimer {
+private:
+    using Clock = std::chrono::steady_clock;
+
+#if TTT_SEARCH_STATS
+    long long& sink_;
+    Clock::time_point start_;
+#endif
+
+public:
+#if TTT_SEARCH_STATS
+    explicit SearchStatsTimer(long long& sink)
+        : sink_(sink), start_(Clock::now()) {}
+
+    ~SearchStatsTimer() {
+        sink_ += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                     Clock::now() - start_).count();
+    }
+#else
+    explicit SearchStatsTimer(long long&) {}
+#endif
+
+    SearchStatsTimer(const SearchStatsTimer&) = delete;
+    SearchStatsTimer& operator=(const SearchStatsTimer&) = delete;
+};
@@ -0,0 +1,340 @@
+// SessionHost.hpp
+#pragma once
+
+#include "TicTacToe.hpp"
+#include "HashTable.hpp"
+#include "DynamicArray.hpp"
+#include "OpeningBook.hpp"
+#include "Trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Много независимых партий в одном процессе.
+//
+// Сессия хранит только свои камни — ни доски-HashTable, ни таблицы
+// транспозиций. Запросы хода ставятся в общую очередь, которую разбирает
+// пул рабочих потоков. У каждого рабочего свой TicTacToeGame: на него
+// расставляются камни сессии, и поиск идёт с «прогретой» таблицей
+// транспозиций (ключи зависят только от позиции, так что сессии ей не
+// мешают). Дебютная книга одна на всех, только для чтения.
+//
+// Очередь — «ближайший срок первым» (EDF), при равных сроках — по
+// порядку поступления. У сессии не больше одного запроса в очереди,
+// поэтому ни одна сессия не может занять пул своими запросами.
+class SessionHost {
+public:
+    using SessionId = std::uint64_t;
+    using Clock = std::chrono::steady_clock;
+
+    struct MoveResult {
+        SessionId session = 0;
+        Position move;
+        int depth = 0;                  // полностью просчитанная глубина
+        bool deadlineMissed = false;    // ответ позже срока
+        double latencyMs = 0.0;         // от RequestMove до ответа
+    };
+
+    using Callback = std::function<void(const MoveResult&)>;
+
+private:
+    struct Session {
+        DynamicArray<Stone> stones;
+        int winLength = 5;
+        bool busy = false;      // запрос в очереди или в работе
+        bool closed = false;    // закрыта во время поиска
+    };
+
+    struct Request {
+        Clock::time_point deadline;
+        std::uint64_t sequence = 0;
+        Clock::time_point submitted;
+        SessionId session = 0;
+        Cell player = EMPTY;
+        Callback callback;
+    };
+
+    // Для кучи: «больше» — тот, кто должен идти позже
+    static bool LaterThan(const Request& a, const Request& b) {
+        if (a.deadline != b.deadline) {
+            return a.deadline > b.deadline;
+        }
+        return a.sequence > b.sequence;
+    }
+
+    HashTable<SessionId, Session*> sessions_;
+    DynamicArray<Request> queue_;               // куча по LaterThan
+    DynamicArray<std::thread> workers_;
+    mutable std::mutex mutex_;
+    std::condition_variable wakeup_;
+    bool stopping_;
+    SessionId nextId_;
+    std::uint64_t nextSequence_;
+
+    const OpeningBook* book_;
+    int maxDepth_;
+    std::size_t ttSize_;
+
+    // Запас на расстановку камней и передачу ответа
+    static constexpr auto kSafetyMargin = std::chrono::milliseconds(2);
+
+    static std::size_t HashId(const SessionId& id) {
+        return static_cast<std::size_t>(HashMix64(id));
+    }
+
+    [[nodiscard]] Session* FindSession(SessionId id) const {
+        if (!sessions_.ContainsKey(id)) {
+            return nullptr;
+        }
+        Session* session = sessions_.Get(id);
+        return session->closed ? nullptr : session;
+    }
+
+    void WorkerLoop(std::size_t index) {
+        if (Tracer::IsEnabled()) {
+            Tracer::SetThreadName("session worker " + std::to_string(index));
+        }
+
+        TicTacToeGame game(5);
+        game.SetOpeningBook(book_);
+        game.SetTranspositionTableSize(ttSize_);
+
+        while (true) {
+            Request request;
+            Session* session = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wakeup_.wait(lock, [this]() {
+                    return stopping_ || !queue_.empty();
+                });
+                if (stopping_) {
+                    return;
+                }
+                std::pop_heap(queue_.begin(), queue_.end(), LaterThan);
+                request = std::move(queue_[queue_.size() - 1]);
+                queue_.pop_back();
+                session = sessions_.Get(request.session);
+            }
+
+            // Пока сессия busy, её камни никто не меняет — читаем без
+            // блокировки
+            TraceScope trace("SessionMove", "worker",
+                             static_cast<std::int64_t>(request.session));
+            if (session->winLength != game.GetWinLength()) {
+                game = TicTacToeGame(session->winLength);
+                game.SetOpeningBook(book_);
+                game.SetTranspositionTableSize(ttSize_);
+            }
+            game.Reset();
+            for (const auto& s : session->stones) {
+                game.MakeMove(s.pos.x, s.pos.y, s.cell);
+            }
+
+            auto now = Clock::now();
+            auto budget = std::chrono::duration_cast<std::chrono::milliseconds>(
+                request.deadline - now - kSafetyMargin);
+            if (budget < std::chrono::milliseconds(1)) {
+                budget = std::chrono::milliseconds(1);
+            }
+
+            MoveResult result;
+            result.session = request.session;
+            result.move = game.FindBestMoveTimed(request.player, budget,
+                                                 maxDepth_);
+            result.depth = game.GetCompletedDepth();
+
+            auto done = Clock::now();
+            result.deadlineMissed = done > request.deadline;
+            result.latencyMs = std::chrono::duration<double, std::milli>(
+                done - request.submitted).count();
+
+            bool closed = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                session->stones.push_back(Stone(result.move, request.player));
+                session->busy = false;
+                closed = session->closed;
+                if (closed) {
+                    sessions_.Remove(request.session);
+                }
+            }
+            if (closed) {
+                delete session;
+            }
+
+            if (request.callback) {
+                request.callback(result);
+            }
+        }
+    }
+
+public:
+    // workers = 0 — по числу ядер; maxDepth — предел итеративного
+    // углубления; book может быть nullptr. Сессии, чья длина линии не
+    // совпадает с книгой, играют без неё (SetOpeningBook).
+    explicit SessionHost(std::size_t workers = 0, int maxDepth = 4,
+                         const OpeningBook* book = nullptr,
+                         std::size_t ttSize = 1 << 16)
+        : sessions_(1024, HashId),
+          queue_(),
+          workers_(),
+          mutex_(),
+          wakeup_(),
+          stopping_(false),
+          nextId_(1),
+          nextSequence_(0),
+          book_(book),
+          maxDepth_(maxDepth),
+          ttSize_(ttSize) {
+
+        if (workers == 0) {
+            workers = std::thread::hardware_concurrency();
+            if (workers == 0) {
+                workers = 1;
+            }
+        }
+        for (std::size_t i = 0; i < workers; ++i) {
+            workers_.push_back(std::thread(&SessionHost::WorkerLoop, this, i));
+        }
+    }
+
+    SessionHost(const SessionHost&) = delete;
+    SessionHost& operator=(const SessionHost&) = delete;
+
+    // Запросы, не взятые в работу, отбрасываются без вызова callback
+    ~SessionHost() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wakeup_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+        sessions_.ForEach([](const SessionId&, Session* session) {
+            delete session;
+        });
+    }
+
+    SessionId CreateSession(int winLength = 5) {
+        Session* session = new Session();
+        session->winLength = winLength;
+        std::lock_guard<std::mutex> lock(mutex_);
+        SessionId id = nextId_++;
+        sessions_.Add(id, session);
+        return id;
+    }
+
+    // Если по сессии идёт поиск, она удаляется после ответа
+    bool CloseSession(SessionId id) {
+        Session* session = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            session = FindSession(id);
+            if (session == nullptr) {
+                return false;
+            }
+            if (session->busy) {
+                session->closed = true;
+                return true;
+            }
+            sessions_.Remove(id);
+        }
+        delete session;
+        return true;
+    }
+
+    // Ход соперника; false — нет сессии, идёт поиск или клетка
+    // занята / вне поля
+    bool Play(SessionId id, int x, int y, Cell player) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Session* session = FindSession(id);
+        if (session == nullptr || session->busy || !IsValidCoord(x, y)) {
+            return false;
+        }
+        for (const auto& s : session->stones) {
+            if (s.pos.x == x && s.pos.y == y) {
+                return false;
+            }
+        }
+        session->stones.push_back(Stone(Position(x, y), player));
+        return true;
+    }
+
+    // Поставить в очередь поиск хода за player со сроком timeLimit от
+    // текущего момента. Ход сразу записывается в сессию, затем
+    // вызывается callback (из рабочего потока). false — нет сессии или
+    // у неё уже есть запрос.
+    bool RequestMove(SessionId id, Cell player,
+                     std::chrono::milliseconds timeLimit, Callback callback) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Session* session = FindSession(id);
+            if (session == nullptr || session->busy) {
+                return false;
+            }
+            session->busy = true;
+
+            Request request;
+            request.submitted = Clock::now();
+            request.deadline = request.submitted + timeLimit;
+            request.sequence = nextSequence_++;
+            request.session = id;
+            request.player = player;
+            request.callback = std::move(callback);
+            queue_.push_back(std::move(request));
+            std::push_heap(queue_.begin(), queue_.end(), LaterThan);
+        }
+        wakeup_.notify_one();
+        return true;
+    }
+
+    // Камни сессии (копия); пусто, если сессии нет
+    [[nodiscard]] DynamicArray<Stone> GetStones(SessionId id) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Session* session = FindSession(id);
+        return session == nullptr ? DynamicArray<Stone>()
+                                  : session->stones;
+    }
+
+    [[nodiscard]] std::size_t GetSessionCount() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return sessions_.GetCount();
+    }
+
+    [[nodiscard]] std::size_t GetQueueLength() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queue_.size();
+    }
+
+    [[nodiscard]] std::size_t GetWorkerCount() const noexcept {
+        return workers_.size();
+    }
+
+    // Память сессии в байтах: сама сессия и буфер камней
+    [[nodiscard]] std::size_t GetSessionMemory(SessionId id) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        Session* session = FindSession(id);
+        if (session == nullptr) {
+            return 0;
+        }
+        return sizeof(Session) + session->stones.capacity() * sizeof(Stone);
+    }
+
+    // Сумма по всем сессиям (без общих ресурсов рабочих потоков)
+    [[nodiscard]] std::size_t GetTotalSessionMemory() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::size_t total = 0;
+        sessions_.ForEach([&total](const SessionId&, Session* session) {
+            total += sizeof(Session) +
+                     session->stones.capacity() * sizeof(Stone);
+        });
+        return total;
+    }
+};
@@ -1,259 +1,406 @@
 // TicTacToe.hpp
 #pragma once
 
+#include "Position.hpp"
 #include "HashTable.hpp"
 #include "DynamicArray.hpp"
+#include "OpeningBook.hpp"
+#include "NnueNetwork.hpp"
+#include "EvalWeights.hpp"
+#include "TranspositionTable.hpp"
+#include "SearchState.hpp"
+#include "SearchStats.hpp"
+#include "Trace.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <limits>
+#include <stdexcept>
 #include <iostream>
 
-struct Position {
-    int x;
-    int y;
-
-    Position(int x_ = 0, int y_ = 0)
-        : x(x_), y(y_) {}
-
-    bool operator==(const Position& other) const noexcept {
-        return x == other.x && y == other.y;
-    }
+// Настройки поиска, которые можно менять между партиями
+// (например, чтобы сравнивать разные конфигурации движка)
+struct SearchConfig {
+    std::size_t rootWidth = 20;          // сколько ходов смотреть в корне
+    std::size_t nodeWidth = 15;          // ... и во внутренних узлах
+    bool useTranspositionTable = true;
 };
 
-// Хеш-функция для Position
-struct PositionHash {
-    std::size_t operator()(const Position& pos) const noexcept {
-        // Cantor pairing + кодирование знака
-        std::size_t a = pos.x >= 0
-                        ? static_cast<std::size_t>(2 * pos.x)
-                        : static_cast<std::size_t>(-2 * pos.x - 1);
-        std::size_t b = pos.y >= 0
-                        ? static_cast<std::size_t>(2 * pos.y)
-                        : static_cast<std::size_t>(-2 * pos.y - 1);
-        return (a + b) * (a + b + 1) / 2 + b;
-    }
+// Одна линия анализа FindBestMoves: ход в корне, его точная оценка
+// с точки зрения ходящего и главный вариант, начиная с этого хода
+struct PrincipalVariation {
+    Position move;
+    int score = 0;
+    DynamicArray<Position> line;
 };
 
-enum Cell {
-    EMPTY = 0,
-    X = 1,
-    O = 2
-};
+// Игра с длиной выигрышной линии WinLength, известной при компиляции:
+// проверка победы и оценка в поиске идут через ядра SearchState с
+// длиной-константой. WinLength = 0 — длина задаётся в конструкторе,
+// ядро выбирается по ней во время выполнения (TicTacToeGame).
+template<int WinLength>
+class BasicTicTacToeGame {
+    static_assert(WinLength >= 0, "WinLength must be non-negative");
 
-class TicTacToeGame {
 private:
     HashTable<Position, Cell>* board_;
     int winLength_;
     PositionHash posHash_;
+    const OpeningBook* book_;   // не владеем, может быть nullptr
+    const NnueNetwork* evaluator_;  // не владеем; nullptr — оценка по линиям
+
+    // Таблица транспозиций выделяется при первом поиске и переживает
+    // Reset(): ключи зависят только от позиции, а не от партии.
+    TranspositionTable tt_;
+    std::size_t ttSize_;
+    SearchConfig config_;
+
+    // Доска поиска с заранее выделенной памятью. const-запросы
+    // (CheckWin, GetPossibleMoves, EvaluatePosition) её не трогают —
+    // у них своя доска в каждом потоке (LoadQueryState), так что их
+    // можно вызывать одновременно из нескольких потоков.
+    SearchState search_;
+
+    // Флаг остановки фонового поиска (не владеем, может быть nullptr)
+    const std::atomic<bool>* stop_;
+    bool aborted_;
+
+    // Срок, после которого поиск прерывается (FindBestMoveTimed)
+    std::chrono::steady_clock::time_point deadline_;
+    bool hasDeadline_;
+    unsigned deadlineCheck_;
+    int completedDepth_;
+    int lastScore_;
+
+    BoardBounds bounds_;
 
     // Статистика для сравнения алгоритмов
-    mutable long long nodesEvaluated_;
+    long long nodesEvaluated_;
+    SearchStats stats_;
+
+    static constexpr std::size_t kDefaultTTSize = 1 << 15;
+    static constexpr std::uint64_t kMaximizingKey = 0x9e3779b97f4a7c15ULL;
+    static constexpr std::uint64_t kPlayerOKey    = 0xc2b2ae3d27d4eb4fULL;
+    // Часы опрашиваются раз в столько внутренних узлов
+    static constexpr unsigned kDeadlineCheckInterval = 256;
+
+    void CreateBoard() {
+        auto hashFunc = [this](const Position& p) { return posHash_(p); };
+        board_ = new HashTable<Position, Cell>(1024, hashFunc);
+    }
 
 public:
-    explicit TicTacToeGame(int winLen = 5)
+    // Для WinLength > 0 winLen должна с ней совпадать
+    explicit BasicTicTacToeGame(int winLen = WinLength > 0 ? WinLength : 5)
         : board_(nullptr),
           winLength_(winLen),
-          nodesEvaluated_(0) {
+          book_(nullptr),
+          evaluator_(nullptr),
+          tt_(),
+          ttSize_(kDefaultTTSize),
+          config_(),
+          search_(),
+          stop_(nullptr),
+          aborted_(false),
+          deadline_(),
+          hasDeadline_(false),
+          deadlineCheck_(0),
+          completedDepth_(0),
+          lastScore_(0),
+          bounds_(),
+          nodesEvaluated_(0),
+          stats_() {
+
+        if (WinLength > 0 && winLen != WinLength) {
+            throw std::invalid_argument("winLen does not match WinLength");
+        }
+        CreateBoard();
+    }
 
-        auto hashFunc = [this](const Position& p) { return posHash_(p); };
-        board_ = new HashTable<Position, Cell>(1024, hashFunc);
+    // Копия получает свою доску и свою таблицу транспозиций;
+    // флаг остановки и срок поиска не копируются.
+    BasicTicTacToeGame(const BasicTicTacToeGame& other)
+        : board_(nullptr),
+          winLength_(other.winLength_),
+          book_(other.book_),
+          evaluator_(other.evaluator_),
+          tt_(other.tt_),
+          ttSize_(other.ttSize_),
+          config_(other.config_),
+          search_(),
+          stop_(nullptr),
+          aborted_(false),
+          deadline_(),
+          hasDeadline_(false),
+          deadlineCheck_(0),
+          completedDepth_(0),
+          lastScore_(0),
+          bounds_(other.bounds_),
+          nodesEvaluated_(0),
+          stats_() {
+
+        CreateBoard();
+        CopyStonesFrom(other);
+        search_.SetNetwork(evaluator_);
+        search_.SetEvalWeights(other.search_.GetEvalWeights());
+    }
+
+    BasicTicTacToeGame& operator=(const BasicTicTacToeGame& other) {
+        if (this != &other) {
+            delete board_;
+            CreateBoard();
+            winLength_ = other.winLength_;
+            book_ = other.book_;
+            evaluator_ = other.evaluator_;
+            search_.SetNetwork(evaluator_);
+            search_.SetEvalWeights(other.search_.GetEvalWeights());
+            tt_ = other.tt_;
+            ttSize_ = other.ttSize_;
+            config_ = other.config_;
+            bounds_ = other.bounds_;
+            aborted_ = false;
+            nodesEvaluated_ = 0;
+            stats_.Clear();
+            CopyStonesFrom(other);
+        }
+        return *this;
     }
 
-    ~TicTacToeGame() {
+    ~BasicTicTacToeGame() {
         delete board_;
     }
 
     void Reset() {
         delete board_;
-        auto hashFunc = [this](const Position& p) { return posHash_(p); };
-        board_ = new HashTable<Position, Cell>(1024, hashFunc);
+        CreateBoard();
         nodesEvaluated_ = 0;
+        stats_.Clear();
     }
 
-    [[nodiscard]] Cell GetCell(int x, int y) const {
-        Position pos(x, y);
-        if (board_->ContainsKey(pos)) {
-            return board_->Get(pos);
-        }
-        return EMPTY;
-    }
-
-    bool MakeMove(int x, int y, Cell player) {
-        Position pos(x, y);
-        if (board_->ContainsKey(pos)) {
+    // Дебютная книга, к которой FindBestMove обращается до поиска.
+    // Книга для другой длины линии не подключается: возвращается false,
+    // и поиск идёт без книги.
+    bool SetOpeningBook(const OpeningBook* book) {
+        if (book != nullptr && book->GetWinLength() != winLength_) {
+            book_ = nullptr;
             return false;
         }
-        board_->Add(pos, player);
+        book_ = book;
         return true;
     }
 
-    [[nodiscard]] bool CheckWin(Cell player) const {
-        auto keys = board_->GetKeys();
+    // Веса оценки по линиям (например, из файла EvalWeights::Load);
+    // можно менять между поисками. Старые оценки в таблице
+    // транспозиций посчитаны с другими весами — она очищается.
+    void SetEvalWeights(const EvalWeights& weights) {
+        search_.SetEvalWeights(weights);
+        tt_.Clear();
+    }
 
-        for (const auto& pos : keys) {
-            if (board_->Get(pos) != player) {
-                continue;
-            }
+    [[nodiscard]] const EvalWeights& GetEvalWeights() const noexcept {
+        return search_.GetEvalWeights();
+    }
 
-            // 4 направления: горизонталь, вертикаль, две диагонали
-            int directions[4][2] = { {1, 0}, {0, 1}, {1, 1}, {1, -1} };
+    // Оценка сетью вместо оценки по линиям (nullptr — вернуть оценку по
+    // линиям). Сеть должна быть для той же длины линии. Оценки сетей
+    // несравнимы, поэтому таблица транспозиций очищается.
+    void SetEvaluator(const NnueNetwork* net) {
+        if (net != nullptr && net->GetWinLength() != winLength_) {
+            throw std::invalid_argument("network win length does not match");
+        }
+        evaluator_ = net;
+        search_.SetNetwork(net);
+        tt_.Clear();
+    }
 
-            for (int d = 0; d < 4; ++d) {
-                int count = 1;
+    [[nodiscard]] const NnueNetwork* GetEvaluator() const noexcept {
+        return evaluator_;
+    }
 
-                // Проверяем в обе стороны
-                for (int dir = -1; dir <= 1; dir += 2) {
-                    int nx = pos.x + directions[d][0] * dir;
-                    int ny = pos.y + directions[d][1] * dir;
+    // Ширина поиска зависит от настроек, поэтому старые записи
+    // таблицы транспозиций при смене настроек отбрасываем
+    void SetSearchConfig(const SearchConfig& config) {
+        config_ = config;
+        tt_.Resize(0);
+    }
 
-                    while (GetCell(nx, ny) == player) {
-                        ++count;
-                        nx += directions[d][0] * dir;
-                        ny += directions[d][1] * dir;
-                    }
-                }
+    [[nodiscard]] const SearchConfig& GetSearchConfig() const {
+        return config_;
+    }
 
-                if (count >= winLength_) {
-                    return true;
-                }
-            }
-        }
-        return false;
+    // Размер таблицы транспозиций в записях (0 — без таблицы)
+    void SetTranspositionTableSize(std::size_t entries) {
+        ttSize_ = entries;
+        tt_.Resize(0);
     }
 
-    [[nodiscard]] DynamicArray<Position> GetPossibleMoves() const {
-        auto keys = board_->GetKeys();
-        DynamicArray<Position> candidates;
-
-        if (keys.empty()) {
-            candidates.push_back(Position(0, 0));
-            return candidates;
-        }
-
-        // Ходы вокруг уже занятых клеток
-        for (const auto& pos : keys) {
-            for (int dx = -1; dx <= 1; ++dx) {
-                for (int dy = -1; dy <= 1; ++dy) {
-                    if (dx == 0 && dy == 0) {
-                        continue;
-                    }
-                    Position newPos(pos.x + dx, pos.y + dy);
-                    if (!board_->ContainsKey(newPos)) {
-                        candidates.push_back(newPos);
-                    }
-                }
-            }
-        }
+    void ClearTranspositionTable() {
+        tt_.Clear();
+    }
 
-        if (candidates.empty()) {
-            return candidates;
-        }
+    // Забрать «прогретую» таблицу у другой партии (например, после
+    // фонового обдумывания на копии); взамен отдаём свою
+    void AdoptTranspositionTable(BasicTicTacToeGame& other) {
+        std::swap(tt_, other.tt_);
+    }
 
-        // Удаляем дубликаты: sort + unique
-        std::sort(
-            candidates.begin(),
-            candidates.end(),
-            [](const Position& a, const Position& b) {
-                return (a.x < b.x) || (a.x == b.x && a.y < b.y);
-            }
-        );
+    // Флаг, по которому поиск прерывается досрочно
+    void SetStopFlag(const std::atomic<bool>* stop) {
+        stop_ = stop;
+    }
 
-        auto uniqueEnd = std::unique(
-            candidates.begin(),
-            candidates.end(),
-            [](const Position& a, const Position& b) {
-                return a.x == b.x && a.y == b.y;
-            }
-        );
+    // Был ли последний FindBestMove прерван флагом остановки или сроком
+    [[nodiscard]] bool WasSearchAborted() const {
+        return aborted_;
+    }
 
-        std::size_t newSize =
-            static_cast<std::size_t>(uniqueEnd - candidates.begin());
-        while (candidates.size() > newSize) {
-            candidates.pop_back();
-        }
+    // Ограничить поле прямоугольником (например, доской 15x15 турнира);
+    // границы обрезаются до допустимых координат. Уже стоящие камни
+    // не проверяются. Оценки в таблице транспозиций посчитаны с другими
+    // кандидатами ходов — она очищается.
+    void SetBoardBounds(const BoardBounds& bounds) {
+        bounds_.minX = std::max(bounds.minX, kMinCoord);
+        bounds_.minY = std::max(bounds.minY, kMinCoord);
+        bounds_.maxX = std::min(bounds.maxX, kMaxCoord);
+        bounds_.maxY = std::min(bounds.maxY, kMaxCoord);
+        tt_.Clear();
+    }
 
-        return candidates;
+    [[nodiscard]] const BoardBounds& GetBoardBounds() const noexcept {
+        return bounds_;
     }
 
-    [[nodiscard]] int EvaluatePosition(Cell player) const {
-        ++nodesEvaluated_;
+    [[nodiscard]] int GetWinLength() const noexcept {
+        return winLength_;
+    }
 
-        if (CheckWin(X)) {
-            return (player == X) ? 10000 : -10000;
+    [[nodiscard]] Cell GetCell(int x, int y) const {
+        Position pos(x, y);
+        if (board_->ContainsKey(pos)) {
+            return board_->Get(pos);
         }
-        if (CheckWin(O)) {
-            return (player == O) ? 10000 : -10000;
+        return EMPTY;
+    }
+
+    // Ход за пределами поля (см. IsValidCoord и SetBoardBounds) или
+    // в занятую клетку отклоняется
+    bool MakeMove(int x, int y, Cell player) {
+        Position pos(x, y);
+        if (!bounds_.Contains(x, y) || board_->ContainsKey(pos)) {
+            return false;
         }
+        board_->Add(pos, player);
+        return true;
+    }
 
-        int score = 0;
-        auto keys = board_->GetKeys();
+    // Снять камень (возврат хода); false, если клетка пуста
+    bool TakeBack(int x, int y) {
+        Position pos(x, y);
+        if (!board_->ContainsKey(pos)) {
+            return false;
+        }
+        board_->Remove(pos);
+        return true;
+    }
 
-        // Оцениваем потенциальные линии
-        int directions[4][2] = { {1, 0}, {0, 1}, {1, 1}, {1, -1} };
+    [[nodiscard]] DynamicArray<Stone> GetStones() const {
+        DynamicArray<Stone> stones;
+        stones.reserve(board_->GetCount());
+        board_->ForEach([&stones](const Position& pos, Cell cell) {
+            stones.push_back(Stone(pos, cell));
+        });
+        return stones;
+    }
 
-        for (const auto& pos : keys) {
-            Cell cell = board_->Get(pos);
-            if (cell == EMPTY) {
-                continue;
-            }
+    [[nodiscard]] bool CheckWin(Cell player) const {
+        TraceScope trace("CheckWin", "board");
+        return CheckWinOn(LoadQueryState(), player);
+    }
 
-            for (int d = 0; d < 4; ++d) {
-                int count = 1;
-                int empty = 0;
-
-                for (int dir = -1; dir <= 1; dir += 2) {
-                    int nx = pos.x + directions[d][0] * dir;
-                    int ny = pos.y + directions[d][1] * dir;
-
-                    for (int step = 0; step < winLength_ - 1; ++step) {
-                        Cell c = GetCell(nx, ny);
-                        if (c == cell) {
-                            ++count;
-                        } else if (c == EMPTY) {
-                            ++empty;
-                        } else {
-                            break;
-                        }
-                        nx += directions[d][0] * dir;
-                        ny += directions[d][1] * dir;
-                    }
-                }
+    [[nodiscard]] DynamicArray<Position> GetPossibleMoves() const {
+        TraceScope trace("GetPossibleMoves", "board");
+        const DynamicArray<Position>& moves =
+            LoadQueryState().GenerateMoves(0);
 
-                if (count + empty >= winLength_) {
-                    int lineScore = count * count * 10;
-                    score += (cell == player) ? lineScore : -lineScore;
-                }
-            }
+        DynamicArray<Position> candidates(moves.size());
+        for (const auto& m : moves) {
+            candidates.push_back(m);
         }
+        return candidates;
+    }
 
-        return score;
+    [[nodiscard]] int EvaluatePosition(Cell player) const {
+        TraceScope trace("EvaluatePosition", "board");
+        return EvaluateOn(LoadQueryState(), player);
     }
 
+    // После первого вызова (выделение таблицы транспозиций и буферов
+    // SearchState) поиск не обращается к куче, если не задана книга.
+    // Прерванный поиск (WasSearchAborted) возвращает лучший из готовых
+    // корневых ходов, а если не готов ни один — первый кандидат.
     [[nodiscard]] Position FindBestMove(Cell player, int depth = 3) {
         nodesEvaluated_ = 0;
+        aborted_ = false;
+        lastScore_ = 0;
+        stats_.Clear();
+        stats_.depth = depth;
+        SearchStatsTimer totalTimer(stats_.totalNs);
+        TraceScope trace("FindBestMove", "search", depth);
+
+        if (book_ != nullptr) {
+            Position bookMove;
+            if (book_->Probe(GetStones(), player, bookMove) &&
+                bounds_.Contains(bookMove.x, bookMove.y) &&
+                GetCell(bookMove.x, bookMove.y) == EMPTY) {
+                return bookMove;
+            }
+        }
+
+        if (config_.useTranspositionTable && !tt_.IsAllocated() &&
+            ttSize_ > 0) {
+            tt_.Resize(ttSize_);
+        }
+
+        {
+            TraceScope loadTrace("LoadBoard", "board",
+                                 static_cast<std::int64_t>(board_->GetCount()));
+            search_.Load(*board_, winLength_, depth + 1, bounds_);
+        }
+        stats_.OnNode(0);
+
         int bestScore = std::numeric_limits<int>::min();
         Position bestMove{0, 0};
 
-        DynamicArray<Position> moves = GetPossibleMoves();
+        const DynamicArray<Position>& moves = SearchGenerateMoves(0);
 
         // Ограничиваем количество ходов для производительности
         std::size_t movesCount = moves.size();
-        if (movesCount > 20) {
-            movesCount = 20;
+        if (movesCount > config_.rootWidth) {
+            movesCount = config_.rootWidth;
         }
 
         for (std::size_t i = 0; i < movesCount; ++i) {
             const Position& move = moves[i];
+            TraceScope moveTrace("RootMove", "search",
+                                 static_cast<std::int64_t>(i));
 
-            board_->Add(move, player);
+            search_.MakeMove(move, player);
             int score = Minimax(
                 depth - 1,
+                /*ply=*/1,
                 /*isMaximizing=*/false,
                 player,
                 std::numeric_limits<int>::min(),
                 std::numeric_limits<int>::max()
             );
-            board_->Remove(move);
+            search_.UndoMove();
+
+            // Оценка прерванного хода неполна — оставляем лучший из готовых
+            if (aborted_) {
+                break;
+            }
 
             if (score > bestScore) {
                 bestScore = score;
@@ -261,13 +408,202 @@ public:
             }
         }
 
+        if (bestScore != std::numeric_limits<int>::min()) {
+            lastScore_ = bestScore;
+        } else if (movesCount > 0) {
+            // Остановлены до конца первого хода: {0, 0} может быть занята,
+            // поэтому отдаём первый кандидат, как FindBestMoveTimed
+            bestMove = moves[0];
+        }
         return bestMove;
     }
 
+    // Итеративное углубление: глубины 1, 2, ... maxDepth, пока не выйдет
+    // budget. Возвращает ход последней полностью просчитанной глубины
+    // (GetCompletedDepth); если не успели и первую — первый кандидат.
+    // Следующая глубина не начинается, если прошло больше половины
+    // бюджета: она заняла бы в разы больше предыдущей.
+    [[nodiscard]] Position FindBestMoveTimed(Cell player,
+                                             std::chrono::milliseconds budget,
+                                             int maxDepth = 64) {
+        TraceScope trace("FindBestMoveTimed", "search",
+                         static_cast<std::int64_t>(budget.count()));
+        auto start = std::chrono::steady_clock::now();
+        deadline_ = start + budget;
+        hasDeadline_ = true;
+        completedDepth_ = 0;
+
+        Position best;
+        int bestScore = 0;
+        SearchStats bestStats;
+        for (int depth = 1; depth <= maxDepth; ++depth) {
+            Position move = FindBestMove(player, depth);
+            if (aborted_) {
+                // Не успели и первую глубину — прерванный FindBestMove
+                // вернул первый кандидат
+                if (depth == 1) {
+                    best = move;
+                }
+                break;
+            }
+            best = move;
+            bestScore = lastScore_;
+            bestStats = stats_;
+            completedDepth_ = depth;
+
+            if (std::chrono::steady_clock::now() - start > budget / 2) {
+                break;
+            }
+        }
+        hasDeadline_ = false;
+        // Оценка и статистика — последней полной глубины, а не прерванной
+        lastScore_ = bestScore;
+        stats_ = bestStats;
+        return best;
+    }
+
+    // count лучших ходов (multi-PV) с точными оценками и главными
+    // вариантами, от лучшего к худшему (при равных оценках — в порядке
+    // кандидатов, так что первая линия — ход FindBestMove). Ходов в корне
+    // не больше rootWidth.
+    //
+    // Все линии считаются в одном поиске на общей таблице транспозиций:
+    // итеративное углубление до depth, корневые ходы на каждой глубине
+    // упорядочены по оценкам предыдущей. Пока линий меньше count, ход
+    // ищется с полным окном; дальше — с окном от оценки count-го
+    // (минус 1, чтобы равные оценки тоже были точными): ход, не
+    // попавший в окно, в линии не входит и отсекается дёшево. Главный
+    // вариант восстанавливается по таблице транспозиций; без неё (или
+    // если запись вытеснена) он обрывается раньше depth. Книга не
+    // используется. При остановке флагом — линии последней полной
+    // глубины (GetCompletedDepth).
+    [[nodiscard]] DynamicArray<PrincipalVariation> FindBestMoves(
+            Cell player, int depth, std::size_t count) {
+        nodesEvaluated_ = 0;
+        aborted_ = false;
+        lastScore_ = 0;
+        completedDepth_ = 0;
+        stats_.Clear();
+        stats_.depth = depth;
+        SearchStatsTimer totalTimer(stats_.totalNs);
+        TraceScope trace("FindBestMoves", "search", depth);
+
+        DynamicArray<PrincipalVariation> lines;
+        if (count == 0 || depth < 1) {
+            return lines;
+        }
+        if (config_.useTranspositionTable && !tt_.IsAllocated() &&
+            ttSize_ > 0) {
+            tt_.Resize(ttSize_);
+        }
+        search_.Load(*board_, winLength_, depth + 1, bounds_);
+        stats_.OnNode(0);
+
+        struct RootMove {
+            Position move;
+            std::size_t index = 0;      // номер в списке кандидатов
+            int score = 0;
+        };
+        auto before = [](const RootMove& a, const RootMove& b) {
+            return a.score > b.score ||
+                   (a.score == b.score && a.index < b.index);
+        };
+
+        const DynamicArray<Position>& moves = SearchGenerateMoves(0);
+        std::size_t movesCount = std::min(moves.size(), config_.rootWidth);
+        DynamicArray<RootMove> roots(movesCount);
+        for (std::size_t i = 0; i < movesCount; ++i) {
+            RootMove root;
+            root.move = moves[i];
+            root.index = i;
+            roots.push_back(root);
+        }
+
+        DynamicArray<RootMove> best(count + 1);     // последняя полная глубина
+        DynamicArray<RootMove> top(count + 1);
+        for (int d = 1; d <= depth; ++d) {
+            top.clear();
+            for (auto& root : roots) {
+                int alpha = std::numeric_limits<int>::min();
+                if (top.size() == count &&
+                    top[count - 1].score > std::numeric_limits<int>::min()) {
+                    alpha = top[count - 1].score - 1;
+                }
+
+                search_.MakeMove(root.move, player);
+                root.score = Minimax(d - 1, 1, false, player, alpha,
+                                     std::numeric_limits<int>::max());
+                search_.UndoMove();
+                if (aborted_) {
+                    break;
+                }
+                if (root.score <= alpha) {
+                    continue;       // только верхняя граница — не в линиях
+                }
+
+                std::size_t at = top.size();
+                top.push_back(root);
+                while (at > 0 && before(root, top[at - 1])) {
+                    top[at] = top[at - 1];
+                    --at;
+                }
+                top[at] = root;
+                if (top.size() > count) {
+                    top.pop_back();
+                }
+            }
+            if (aborted_) {
+                break;
+            }
+            best = top;
+            completedDepth_ = d;
+            // Порядок для следующей глубины; у ходов вне линий оценка —
+            // верхняя граница, но для порядка её хватает
+            std::stable_sort(roots.begin(), roots.end(),
+                             [](const RootMove& a, const RootMove& b) {
+                                 return a.score > b.score;
+                             });
+        }
+
+        for (const auto& root : best) {
+            PrincipalVariation pv;
+            pv.move = root.move;
+            pv.score = root.score;
+            pv.line.push_back(root.move);
+            search_.MakeMove(root.move, player);
+            CollectLine(player, completedDepth_ - 1, pv.line);
+            search_.UndoMove();
+            lines.push_back(std::move(pv));
+        }
+        if (!lines.empty()) {
+            lastScore_ = lines[0].score;
+        }
+        return lines;
+    }
+
+    // Оценка хода, найденного последним FindBestMove/FindBestMoveTimed,
+    // с точки зрения ходившего; 0 — ход из книги или поиск не успел
+    [[nodiscard]] int GetLastScore() const noexcept {
+        return lastScore_;
+    }
+
+    // Глубина, до которой досчитал последний FindBestMoveTimed
+    [[nodiscard]] int GetCompletedDepth() const noexcept {
+        return completedDepth_;
+    }
+
+    // Вызовы Minimax вместе с вызовами оценки — счётчик для старых
+    // сравнений; подробности — в GetSearchStats()
     [[nodiscard]] long long GetNodesEvaluated() const {
         return nodesEvaluated_;
     }
 
+    // Статистика последнего FindBestMove (нули при TTT_SEARCH_STATS=0
+    // и при ходе из книги)
+    [[nodiscard]] const SearchStats& GetSearchStats() const noexcept {
+        return stats_;
+    }
+
     void Display(int minX, int maxX, int minY, int maxY) const {
         std::cout << "\n   ";
         for (int x = minX; x <= maxX; ++x) {
@@ -288,66 +624,217 @@ public:
     }
 
 private:
-    int Minimax(int depth, bool isMaximizing, Cell player,
-                int alpha, int beta) const {
+    void CopyStonesFrom(const BasicTicTacToeGame& other) {
+        other.board_->ForEach([this](const Position& pos, Cell cell) {
+            board_->Add(pos, cell);
+        });
+    }
+
+    // Доска const-запросов: одна на поток (и на WinLength), память
+    // переживает вызовы. Сеть и веса — те же, что у поиска этой партии.
+    [[nodiscard]] SearchState& LoadQueryState() const {
+        static thread_local SearchState state;
+        if (state.GetNetwork() != evaluator_) {
+            state.SetNetwork(evaluator_);
+        }
+        state.SetEvalWeights(search_.GetEvalWeights());
+        state.Load(*board_, winLength_, 1, bounds_);
+        return state;
+    }
+
+    [[nodiscard]] bool CheckWinOn(SearchState& state, Cell player) const {
+        if (evaluator_ != nullptr) {
+            return state.CheckWinNnue(player);
+        }
+        return state.HasLine(player);
+    }
+
+    [[nodiscard]] int EvaluateOn(SearchState& state, Cell player) const {
+        if (evaluator_ != nullptr) {
+            return state.EvaluateNnue(player);
+        }
+        if constexpr (WinLength > 0) {
+            return state.EvaluateFixed<WinLength>(player);
+        } else {
+            return state.Evaluate(player);
+        }
+    }
+
+    [[nodiscard]] bool SearchCheckWin(Cell player) {
+        return CheckWinOn(search_, player);
+    }
+
+    [[nodiscard]] int SearchEvaluate(Cell player) {
+        return EvaluateOn(search_, player);
+    }
+
+    const DynamicArray<Position>& SearchGenerateMoves(std::size_t ply) {
+        SearchStatsTimer timer(stats_.moveGenNs);
+        return search_.GenerateMoves(ply);
+    }
+
+    [[nodiscard]] bool StopRequested() {
+        if (stop_ != nullptr && stop_->load(std::memory_order_relaxed)) {
+            aborted_ = true;
+        }
+        if (hasDeadline_ && ++deadlineCheck_ % kDeadlineCheckInterval == 0 &&
+            std::chrono::steady_clock::now() >= deadline_) {
+            aborted_ = true;
+        }
+        return aborted_;
+    }
+
+    // Ключ узла в таблице транспозиций: оценка зависит от позиции,
+    // очерёдности и того, за кого считаем
+    [[nodiscard]] std::uint64_t NodeKey(bool isMaximizing,
+                                        Cell player) const {
+        return search_.Hash()
+             ^ (isMaximizing ? kMaximizingKey : 0)
+             ^ (player == O ? kPlayerOKey : 0);
+    }
+
+    // Главный вариант после корневого хода: по лучшим ходам из точных
+    // записей таблицы транспозиций, пока они есть. search_ — позиция
+    // после корневого хода, depth — оставшаяся глубина.
+    void CollectLine(Cell player, int depth, DynamicArray<Position>& line) {
+        std::size_t made = 0;
+        bool isMaximizing = false;
+        std::size_t ply = 1;
+        while (depth > 0 && !SearchCheckWin(X) && !SearchCheckWin(O)) {
+            const auto* entry = tt_.Probe(NodeKey(isMaximizing, player),
+                                          depth);
+            if (entry == nullptr ||
+                entry->bound != TranspositionTable::BOUND_EXACT) {
+                break;
+            }
+            const DynamicArray<Position>& moves = search_.GenerateMoves(ply);
+            if (entry->move >= moves.size()) {
+                break;
+            }
+            Position move = moves[entry->move];
+            search_.MakeMove(move, isMaximizing ? player
+                                                : (player == X ? O : X));
+            line.push_back(move);
+            ++made;
+            --depth;
+            ++ply;
+            isMaximizing = !isMaximizing;
+        }
+        for (std::size_t i = 0; i < made; ++i) {
+            search_.UndoMove();
+        }
+    }
+
+    int Minimax(int depth, std::size_t ply, bool isMaximizing, Cell player,
+                int alpha, int beta) {
         ++nodesEvaluated_;
+        stats_.OnNode(ply);
 
-        if (depth == 0 || CheckWin(X) || CheckWin(O)) {
-            return EvaluatePosition(player);
+        bool terminal = (depth == 0);
+        if (!terminal) {
+            SearchStatsTimer timer(stats_.winCheckNs);
+            terminal = SearchCheckWin(X) || SearchCheckWin(O);
+        }
+        if (terminal) {
+            ++nodesEvaluated_;
+            stats_.OnLeaf();
+            SearchStatsTimer timer(stats_.evalNs);
+            return SearchEvaluate(player);
+        }
+
+        if (StopRequested()) {
+            return 0;
         }
 
-        DynamicArray<Position> moves = GetPossibleMoves();
+        std::uint64_t key = NodeKey(isMaximizing, player);
+        if (const auto* entry = tt_.Probe(key, depth)) {
+            if (entry->bound == TranspositionTable::BOUND_EXACT ||
+                (entry->bound == TranspositionTable::BOUND_LOWER &&
+                 entry->score >= beta) ||
+                (entry->bound == TranspositionTable::BOUND_UPPER &&
+                 entry->score <= alpha)) {
+                stats_.OnTTHit();
+                return entry->score;
+            }
+        }
+        const int alphaOrig = alpha;
+        const int betaOrig = beta;
+
+        const DynamicArray<Position>& moves = SearchGenerateMoves(ply);
         if (moves.empty()) {
             return 0;
         }
 
         std::size_t movesCount = moves.size();
-        if (movesCount > 15) {
-            movesCount = 15;
+        if (movesCount > config_.nodeWidth) {
+            movesCount = config_.nodeWidth;
         }
 
         Cell currentPlayer = isMaximizing ? player : (player == X ? O : X);
+        int result;
+        std::size_t bestIndex = 0;
 
         if (isMaximizing) {
             int maxScore = std::numeric_limits<int>::min();
             for (std::size_t i = 0; i < movesCount; ++i) {
                 const Position& move = moves[i];
 
-                board_->Add(move, currentPlayer);
-                int score = Minimax(depth - 1, false, player, alpha, beta);
-                board_->Remove(move);
+                search_.MakeMove(move, currentPlayer);
+                int score = Minimax(depth - 1, ply + 1, false, player,
+                                    alpha, beta);
+                search_.UndoMove();
 
                 if (score > maxScore) {
                     maxScore = score;
+                    bestIndex = i;
                 }
                 if (score > alpha) {
                     alpha = score;
                 }
                 if (beta <= alpha) {
+                    stats_.OnCutoff(i);
                     break;
                 }
             }
-            return maxScore;
+            result = maxScore;
         } else {
             int minScore = std::numeric_limits<int>::max();
             for (std::size_t i = 0; i < movesCount; ++i) {
                 const Position& move = moves[i];
 
-                board_->Add(move, currentPlayer);
-                int score = Minimax(depth - 1, true, player, alpha, beta);
-                board_->Remove(move);
+                search_.MakeMove(move, currentPlayer);
+                int score = Minimax(depth - 1, ply + 1, true, player,
+                                    alpha, beta);
+                search_.UndoMove();
 
                 if (score < minScore) {
                     minScore = score;
+                    bestIndex = i;
                 }
                 if (score < beta) {
                     beta = score;
                 }
                 if (beta <= alpha) {
+                    stats_.OnCutoff(i);
                     break;
                 }
             }
-            return minScore;
+            result = minScore;
+        }
+
+        // Результат прерванного поддерева в таблицу не попадает
+        if (aborted_) {
+            return result;
         }
+
+        TranspositionTable::Bound bound =
+            (result <= alphaOrig) ? TranspositionTable::BOUND_UPPER
+          : (result >= betaOrig)  ? TranspositionTable::BOUND_LOWER
+                                  : TranspositionTable::BOUND_EXACT;
+        tt_.Store(key, depth, result, bound, bestIndex);
+        return result;
     }
 };
+
+// Длина линии задаётся при создании: TicTacToeGame game(5)
+using TicTacToeGame = BasicTicTacToeGame<0>;
@@ -0,0 +1,263 @@
+// Tournament.hpp
+#pragma once
+
+#include "TicTacToe.hpp"
+#include "DynamicArray.hpp"
+#include "GameRecord.hpp"
+#include "MctsSearch.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+
+enum class EngineKind {
+    MINIMAX,
+    MCTS
+};
+
+// Конфигурация движка-участника
+struct EngineConfig {
+    std::string name = "engine";
+    EngineKind kind = EngineKind::MINIMAX;
+    int depth = 2;
+    SearchConfig search;
+    MctsSettings mcts;                 // для EngineKind::MCTS
+    const NnueNetwork* evaluator = nullptr;  // сеть оценки; не владеем
+    EvalWeights weights;               // веса оценки по линиям
+};
+
+struct TournamentSettings {
+    int games = 100;                   // всего партий (чётное — пары с обменом цветов)
+    int threads = 0;                   // 0 — по числу ядер
+    int winLength = 5;
+    int openingRandomMovesLimit = 2;   // случайные первые ходы, как в demoMode
+    int maxMoves = 40;                 // после стольких ходов — ничья
+    std::uint32_t seed = 1;
+    GameRecordWriter* recorder = nullptr;   // куда дописывать партии
+};
+
+// Результат одной партии с точки зрения движка A
+struct GameResult {
+    int index = 0;
+    bool aIsX = true;
+    int outcome = 0;                   // +1 победа A, 0 ничья, -1 победа B
+    int plies = 0;
+    int aMoves = 0;
+    int bMoves = 0;
+    double aTimeMs = 0.0;
+    double bTimeMs = 0.0;
+};
+
+struct TournamentSummary {
+    int wins = 0;
+    int draws = 0;
+    int losses = 0;
+    double score = 0.0;                // доля очков A
+    double eloDiff = 0.0;              // A относительно B
+    double eloError = 0.0;             // полуширина 95% интервала
+    double aAvgMoveMs = 0.0;
+    double bAvgMoveMs = 0.0;
+};
+
+// Безынтерфейсный матч A против B: партии играются параллельно на всех
+// ядрах, каждый поток берёт следующий номер партии из общего счётчика.
+// Партии 2k и 2k+1 начинаются с одного и того же случайного дебюта,
+// но с обменом цветов — так дебютная удача не искажает результат.
+class Tournament {
+private:
+    static GameResult PlayGame(const EngineConfig& a, const EngineConfig& b,
+                               const TournamentSettings& settings,
+                               int index) {
+        GameResult result;
+        result.index = index;
+        result.aIsX = (index % 2 == 0);
+
+        // У каждого движка своя копия доски (и своя таблица транспозиций)
+        TicTacToeGame gameA(settings.winLength);
+        TicTacToeGame gameB(settings.winLength);
+        gameA.SetSearchConfig(a.search);
+        gameB.SetSearchConfig(b.search);
+        gameA.SetEvalWeights(a.weights);
+        gameB.SetEvalWeights(b.weights);
+        gameA.SetEvaluator(a.evaluator);
+        gameB.SetEvaluator(b.evaluator);
+        // Дерево MCTS тоже у каждого своё и переживает ходы партии
+        MctsSearch mctsA(a.mcts);
+        MctsSearch mctsB(b.mcts);
+
+        std::mt19937 rng(settings.seed + static_cast<std::uint32_t>(index / 2));
+        bool xTurn = true;
+        DynamicArray<Position> played;
+        Cell winner = EMPTY;
+
+        for (int moveIndex = 0; moveIndex < settings.maxMoves; ++moveIndex) {
+            Cell player = xTurn ? X : O;
+            bool aToMove = (player == X) == result.aIsX;
+            Position move;
+
+            if (moveIndex < settings.openingRandomMovesLimit) {
+                DynamicArray<Position> moves = gameA.GetPossibleMoves();
+                std::uniform_int_distribution<int> dist(
+                    0, static_cast<int>(moves.size()) - 1);
+                move = moves[static_cast<std::size_t>(dist(rng))];
+            } else {
+                TicTacToeGame& engine = aToMove ? gameA : gameB;
+                const EngineConfig& config = aToMove ? a : b;
+
+                auto start = std::chrono::steady_clock::now();
+                if (config.kind == EngineKind::MCTS) {
+                    move = (aToMove ? mctsA : mctsB).FindBestMove(engine,
+                                                                  player);
+                } else {
+                    move = engine.FindBestMove(player, config.depth);
+                }
+                auto end = std::chrono::steady_clock::now();
+                double ms =
+                    std::chrono::duration<double, std::milli>(end - start)
+                        .count();
+
+                if (aToMove) {
+                    result.aTimeMs += ms;
+                    ++result.aMoves;
+                } else {
+                    result.bTimeMs += ms;
+                    ++result.bMoves;
+                }
+            }
+
+            gameA.MakeMove(move.x, move.y, player);
+            gameB.MakeMove(move.x, move.y, player);
+            played.push_back(move);
+            ++result.plies;
+
+            if (gameA.CheckWin(player)) {
+                result.outcome = aToMove ? 1 : -1;
+                winner = player;
+                break;
+            }
+            xTurn = !xTurn;
+        }
+
+        if (settings.recorder != nullptr) {
+            settings.recorder->Append(played, settings.winLength, winner);
+        }
+        return result;
+    }
+
+public:
+    static DynamicArray<GameResult> Run(const EngineConfig& a,
+                                        const EngineConfig& b,
+                                        const TournamentSettings& settings) {
+        DynamicArray<GameResult> results(
+            static_cast<std::size_t>(settings.games));
+        for (int i = 0; i < settings.games; ++i) {
+            results.push_back(GameResult());
+        }
+
+        int threads = settings.threads;
+        if (threads <= 0) {
+            threads = static_cast<int>(std::thread::hardware_concurrency());
+            if (threads <= 0) {
+                threads = 1;
+            }
+        }
+        if (threads > settings.games) {
+            threads = settings.games;
+        }
+
+        std::atomic<int> next(0);
+        auto worker = [&](int t) {
+            if (Tracer::IsEnabled()) {
+                Tracer::SetThreadName("tournament " + std::to_string(t));
+            }
+            for (int i = next.fetch_add(1); i < settings.games;
+                 i = next.fetch_add(1)) {
+                TraceScope trace("Game", "worker", i);
+                // Каждый поток пишет только в свою ячейку результатов
+                results[static_cast<std::size_t>(i)] =
+                    PlayGame(a, b, settings, i);
+            }
+        };
+
+        DynamicArray<std::thread> pool;
+        for (int t = 0; t < threads; ++t) {
+            pool.push_back(std::thread(worker, t));
+        }
+        for (auto& th : pool) {
+            th.join();
+        }
+        return results;
+    }
+
+    static TournamentSummary Summarize(const DynamicArray<GameResult>& results) {
+        TournamentSummary s;
+        double aTime = 0.0, bTime = 0.0;
+        long long aMoves = 0, bMoves = 0;
+
+        for (const auto& r : results) {
+            if (r.outcome > 0) {
+                ++s.wins;
+            } else if (r.outcome < 0) {
+                ++s.losses;
+            } else {
+                ++s.draws;
+            }
+            aTime += r.aTimeMs;
+            bTime += r.bTimeMs;
+            aMoves += r.aMoves;
+            bMoves += r.bMoves;
+        }
+
+        const double n = static_cast<double>(results.size());
+        if (n == 0) {
+            return s;
+        }
+
+        s.score = (s.wins + 0.5 * s.draws) / n;
+        s.aAvgMoveMs = aMoves > 0 ? aTime / static_cast<double>(aMoves) : 0.0;
+        s.bAvgMoveMs = bMoves > 0 ? bTime / static_cast<double>(bMoves) : 0.0;
+
+        // Дисперсия очков за партию -> 95% интервал для доли очков
+        double p = s.score;
+        double variance = (s.wins * (1.0 - p) * (1.0 - p) +
+                           s.draws * (0.5 - p) * (0.5 - p) +
+                           s.losses * p * p) / n;
+        double margin = 1.96 * std::sqrt(variance / n);
+
+        s.eloDiff = EloFromScore(p);
+        s.eloError = (EloFromScore(p + margin) - EloFromScore(p - margin)) / 2;
+        return s;
+    }
+
+    // Разница рейтингов по доле набранных очков
+    static double EloFromScore(double score) {
+        const double eps = 1e-6;
+        if (score < eps) {
+            score = eps;
+        } else if (score > 1.0 - eps) {
+            score = 1.0 - eps;
+        }
+        return -400.0 * std::log10(1.0 / score - 1.0);
+    }
+
+    static bool WriteCsv(const std::string& path,
+                         const DynamicArray<GameResult>& results) {
+        std::ofstream csv(path);
+        if (!csv.is_open()) {
+            return false;
+        }
+        csv << "game,a_color,outcome,plies,a_ms_per_move,b_ms_per_move\n";
+        for (const auto& r : results) {
+            csv << r.index << ',' << (r.aIsX ? 'X' : 'O') << ','
+                << r.outcome << ',' << r.plies << ','
+                << (r.aMoves > 0 ? r.aTimeMs / r.aMoves : 0.0) << ','
+                << (r.bMoves > 0 ? r.bTimeMs / r.bMoves : 0.0) << '\n';
+        }
+        return static_cast<bool>(csv);
+    }
+};
@@ -0,0 +1,302 @@
+// Trace.hpp
+#pragma once
+
+#include "DynamicArray.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+// Трассировка поиска в формате Chrome Trace Event (открывается в
+// Perfetto или chrome://tracing). По умолчанию вырезана при компиляции:
+// TraceScope — пустой объект. Сборка с -DTTT_TRACE=1 включает код,
+// а запись начинается после Tracer::Enable(true).
+//
+// Каждый поток пишет в свой кольцевой буфер без блокировок; при
+// переполнении старые события затираются, а буфер завершившегося потока
+// вместе с событиями переходит к следующему новому потоку, так что память
+// ограничена числом одновременно живых потоков. Сбрасывать трассу
+// (WriteChromeTrace) нужно, когда трассируемая работа закончилась.
+#ifndef TTT_TRACE
+#define TTT_TRACE 0
+#endif
+
+// Имя и категория — строковые литералы: событие хранит только указатели
+struct TraceEvent {
+    const char* name = "";
+    const char* category = "";
+    std::int64_t arg = 0;
+    std::uint64_t startNs = 0;
+    std::uint64_t durationNs = 0;
+};
+
+// Кольцевой буфер одного потока: пишет только владелец
+class TraceBuffer {
+private:
+    DynamicArray<TraceEvent> events_;
+    std::size_t mask_;
+    std::atomic<std::uint64_t> head_;
+    std::uint32_t threadId_;
+
+public:
+    // capacity — степень двойки
+    TraceBuffer(std::size_t capacity, std::uint32_t threadId)
+        : events_(capacity), mask_(capacity - 1), head_(0),
+          threadId_(threadId) {
+        for (std::size_t i = 0; i < capacity; ++i) {
+            events_.push_back(TraceEvent());
+        }
+    }
+
+    void Push(const TraceEvent& event) {
+        std::uint64_t head = head_.load(std::memory_order_relaxed);
+        events_[static_cast<std::size_t>(head) & mask_] = event;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    void Clear() {
+        head_.store(0, std::memory_order_release);
+    }
+
+    [[nodiscard]] std::uint32_t GetThreadId() const noexcept {
+        return threadId_;
+    }
+
+    // Сохранённые события от старых к новым
+    template<typename Func>
+    void ForEach(Func&& func) const {
+        std::uint64_t head = head_.load(std::memory_order_acquire);
+        std::uint64_t capacity = mask_ + 1;
+        std::uint64_t first = head > capacity ? head - capacity : 0;
+        for (std::uint64_t i = first; i < head; ++i) {
+            func(events_[static_cast<std::size_t>(i) & mask_]);
+        }
+    }
+};
+
+class Tracer {
+public:
+    static constexpr bool kCompiled = TTT_TRACE != 0;
+    static constexpr std::size_t kDefaultBufferCapacity = 1 << 16;
+
+    static void Enable(bool enabled) {
+        GetState().enabled.store(kCompiled && enabled,
+                                 std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] static bool IsEnabled() {
+        if constexpr (kCompiled) {
+            return GetState().enabled.load(std::memory_order_relaxed);
+        } else {
+            return false;
+        }
+    }
+
+    // Ёмкость (в событиях) буферов потоков, которые начнут писать позже;
+    // округляется вверх до степени двойки
+    static void SetBufferCapacity(std::size_t events) {
+        std::size_t capacity = 1;
+        while (capacity < events) {
+            capacity <<= 1;
+        }
+        State& state = GetState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.capacity = capacity;
+    }
+
+    // Имя текущего потока в трассе
+    static void SetThreadName(const std::string& name) {
+        if constexpr (kCompiled) {
+            TraceBuffer* buffer = ThreadBuffer();
+            State& state = GetState();
+            std::lock_guard<std::mutex> lock(state.mutex);
+            state.threadNames[buffer->GetThreadId()] = name;
+        } else {
+            (void)name;
+        }
+    }
+
+    [[nodiscard]] static std::uint64_t NowNs() {
+        return static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                Clock::now() - GetState().epoch).count());
+    }
+
+    static void Record(const char* name, const char* category,
+                       std::int64_t arg, std::uint64_t startNs,
+                       std::uint64_t durationNs) {
+        TraceEvent event;
+        event.name = name;
+        event.category = category;
+        event.arg = arg;
+        event.startNs = startNs;
+        event.durationNs = durationNs;
+        ThreadBuffer()->Push(event);
+    }
+
+    // Забыть записанные события (буферы потоков остаются)
+    static void Clear() {
+        State& state = GetState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        for (const auto& buffer : state.buffers) {
+            buffer->Clear();
+        }
+    }
+
+    // JSON с полными событиями ("ph": "X") и именами потоков
+    static bool WriteChromeTrace(std::ostream& out) {
+        State& state = GetState();
+        std::lock_guard<std::mutex> lock(state.mutex);
+
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        auto separator = [&out, &first]() {
+            out << (first ? "\n" : ",\n");
+            first = false;
+        };
+
+        for (const auto& buffer : state.buffers) {
+            std::uint32_t tid = buffer->GetThreadId();
+            if (!state.threadNames[tid].empty()) {
+                separator();
+                out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                    << "\"tid\":" << tid << ",\"args\":{\"name\":\"";
+                WriteEscaped(out, state.threadNames[tid]);
+                out << "\"}}";
+            }
+
+            buffer->ForEach([&](const TraceEvent& e) {
+                separator();
+                out << "{\"name\":\"";
+                WriteEscaped(out, e.name);
+                out << "\",\"cat\":\"";
+                WriteEscaped(out, e.category);
+                out << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                    << ",\"ts\":" << e.startNs / 1000 << '.'
+                    << Fraction(e.startNs) << ",\"dur\":"
+                    << e.durationNs / 1000 << '.' << Fraction(e.durationNs)
+                    << ",\"args\":{\"arg\":" << e.arg << "}}";
+            });
+        }
+        out << "\n]}\n";
+        return static_cast<bool>(out);
+    }
+
+    static bool WriteChromeTrace(const std::string& path) {
+        std::ofstream out(path);
+        if (!out.is_open()) {
+            return false;
+        }
+        return WriteChromeTrace(out);
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct State {
+        std::mutex mutex;
+        DynamicArray<std::unique_ptr<TraceBuffer>> buffers;
+        DynamicArray<TraceBuffer*> freeBuffers;    // от завершившихся потоков
+        DynamicArray<std::string> threadNames;     // по номеру потока
+        std::atomic<bool> enabled{false};
+        std::size_t capacity = kDefaultBufferCapacity;
+        Clock::time_point epoch = Clock::now();
+    };
+
+    static State& GetState() {
+        static State state;
+        return state;
+    }
+
+    // Буфер потока: при завершении потока возвращается в freeBuffers
+    struct BufferLease {
+        TraceBuffer* buffer = nullptr;
+
+        ~BufferLease() {
+            if (buffer != nullptr) {
+                State& state = GetState();
+                std::lock_guard<std::mutex> lock(state.mutex);
+                state.freeBuffers.push_back(buffer);
+            }
+        }
+    };
+
+    // Буфер текущего потока; создаётся при первом событии и живёт до
+    // конца программы, чтобы события завершившихся потоков не терялись
+    static TraceBuffer* ThreadBuffer() {
+        thread_local BufferLease lease;
+        if (lease.buffer == nullptr) {
+            State& state = GetState();
+            std::lock_guard<std::mutex> lock(state.mutex);
+            if (!state.freeBuffers.empty()) {
+                lease.buffer = state.freeBuffers[state.freeBuffers.size() - 1];
+                state.freeBuffers.pop_back();
+            } else {
+                std::uint32_t tid =
+                    static_cast<std::uint32_t>(state.buffers.size());
+                state.buffers.push_back(
+                    std::make_unique<TraceBuffer>(state.capacity, tid));
+                state.threadNames.push_back(std::string());
+                lease.buffer = state.buffers[tid].get();
+            }
+        }
+        return lease.buffer;
+    }
+
+    // Три знака после запятой для микросекунд
+    static std::string Fraction(std::uint64_t ns) {
+        std::string digits = std::to_string(ns % 1000);
+        return std::string(3 - digits.size(), '0') + digits;
+    }
+
+    static void WriteEscaped(std::ostream& out, const std::string& text) {
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                out << '\\' << c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                out << ' ';
+            } else {
+                out << c;
+            }
+        }
+    }
+};
+
+// Событие длиной во время жизни объекта:
+//   TraceScope trace("FindBestMove", "search", depth);
+class TraceScope {
+private:
+#if TTT_TRACE
+    const char* name_;
+    const char* category_;
+    std::int64_t arg_;
+    bool active_;
+    std::uint64_t startNs_;
+#endif
+
+public:
+#if TTT_TRACE
+    TraceScope(const char* name, const char* category, std::int64_t arg = 0)
+        : name_(name), category_(category), arg_(arg),
+          active_(Tracer::IsEnabled()),
+          startNs_(active_ ? Tracer::NowNs() : 0) {}
+
+    ~TraceScope() {
+        if (active_) {
+            Tracer::Record(name_, category_, arg_, startNs_,
+                           Tracer::NowNs() - startNs_);
+        }
+    }
+#else
+    TraceScope(const char*, const char*, std::int64_t = 0) {}
+#endif
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
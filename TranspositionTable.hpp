@@ -0,0 +1,105 @@
+// TranspositionTable.hpp
+#pragma once
+
+#include "DynamicArray.hpp"
+#include "Trace.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+// Таблица транспозиций для minimax: фиксированный массив, индекс —
+// младшие биты ключа, при коллизии запись просто замещается.
+//
+// Запись используется только при совпадении оставшейся глубины: поиск
+// ограничен и по глубине, и по ширине, поэтому оценка с другой глубиной
+// не эквивалентна, а результат поиска с таблицей обязан совпадать
+// с результатом без неё.
+class TranspositionTable {
+public:
+    enum Bound : std::uint8_t {
+        BOUND_NONE  = 0,
+        BOUND_EXACT = 1,
+        BOUND_LOWER = 2,   // истинная оценка >= score
+        BOUND_UPPER = 3    // истинная оценка <= score
+    };
+
+    // Номер лучшего хода в списке кандидатов узла (GenerateMoves
+    // детерминирован, так что номер однозначно задаёт ход); kNoMove —
+    // неизвестен
+    static constexpr std::uint8_t kNoMove = 0xFF;
+
+    struct Entry {
+        std::uint64_t key;
+        std::int32_t score;
+        std::int16_t depth;
+        std::uint8_t bound;
+        std::uint8_t move;
+    };
+
+private:
+    DynamicArray<Entry> entries_;
+    std::size_t mask_;
+
+public:
+    // size округляется вверх до степени двойки
+    explicit TranspositionTable(std::size_t size = 0)
+        : entries_(), mask_(0) {
+        Resize(size);
+    }
+
+    void Resize(std::size_t size) {
+        TraceScope trace("ResizeTT", "tt", static_cast<std::int64_t>(size));
+        std::size_t capacity = 1;
+        while (capacity < size) {
+            capacity <<= 1;
+        }
+        entries_ = DynamicArray<Entry>(size == 0 ? 0 : capacity);
+        for (std::size_t i = 0; size != 0 && i < capacity; ++i) {
+            entries_.push_back(Entry{0, 0, 0, BOUND_NONE, kNoMove});
+        }
+        mask_ = (size == 0) ? 0 : capacity - 1;
+    }
+
+    void Clear() {
+        for (auto& e : entries_) {
+            e = Entry{0, 0, 0, BOUND_NONE, kNoMove};
+        }
+    }
+
+    [[nodiscard]] bool IsAllocated() const noexcept {
+        return !entries_.empty();
+    }
+
+    [[nodiscard]] std::size_t GetSize() const noexcept {
+        return entries_.size();
+    }
+
+    [[nodiscard]] std::size_t GetMemoryUsage() const noexcept {
+        return entries_.capacity() * sizeof(Entry);
+    }
+
+    [[nodiscard]] const Entry* Probe(std::uint64_t key, int depth) const {
+        if (entries_.empty()) {
+            return nullptr;
+        }
+        const Entry& e = entries_[key & mask_];
+        if (e.bound == BOUND_NONE || e.key != key || e.depth != depth) {
+            return nullptr;
+        }
+        return &e;
+    }
+
+    // move — номер лучшего хода; больше 254 не хранится
+    void Store(std::uint64_t key, int depth, int score, Bound bound,
+               std::size_t move = kNoMove) {
+        if (entries_.empty()) {
+            return;
+        }
+        Entry& e = entries_[key & mask_];
+        e.key = key;
+        e.score = score;
+        e.depth = static_cast<std::int16_t>(depth);
+        e.bound = bound;
+        e.move = static_cast<std::uint8_t>(move < kNoMove ? move : kNoMove);
+    }
+};
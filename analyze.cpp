@@ -0,0 +1,103 @@
+// analyze.cpp — пакетный анализ позиций из файла
+//
+// Использование (все параметры необязательны):
+//   analyze in=positions.txt out=analysis.csv depth=3 limit=0 threads=0
+//           window=0 win=5 root=20 width=15 tt=1 fresh=1 weights=
+//           multipv=0
+//
+// Каждая строка входа — запись партии "x,y x,y ..." (первым ходит X);
+// пустые строки и строки, начинающиеся с '#', пропускаются. "-" вместо
+// файла — стандартный ввод или вывод. limit > 0 — итеративное углубление
+// с лимитом в миллисекундах на позицию (depth — предельная глубина).
+// Результаты в CSV идут в порядке входа. weights — файл весов оценки
+// (EvalWeights.hpp, например из tune). multipv=K > 0 — K лучших ходов
+// с оценками и главными вариантами в столбце lines (limit тогда не
+// действует).
+
+#include "BatchAnalyzer.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+int main(int argc, char** argv) {
+    AnalysisSettings settings;
+    std::string inPath = "-";
+    std::string outPath = "-";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::size_t eq = arg.find('=');
+        if (eq == std::string::npos) {
+            std::cerr << "Ожидался параметр вида ключ=значение: " << arg << "\n";
+            return 1;
+        }
+        std::string key = arg.substr(0, eq);
+        std::string value = arg.substr(eq + 1);
+
+        bool ok = true;
+        if (key == "in") {
+            inPath = value;
+        } else if (key == "out") {
+            outPath = value;
+        } else if (key == "depth") {
+            settings.depth = std::stoi(value);
+        } else if (key == "limit") {
+            settings.timeLimitMs = std::stoi(value);
+        } else if (key == "threads") {
+            settings.threads = static_cast<std::size_t>(std::stoul(value));
+        } else if (key == "window") {
+            settings.window = static_cast<std::size_t>(std::stoul(value));
+        } else if (key == "win") {
+            settings.winLength = std::stoi(value);
+        } else if (key == "root") {
+            settings.search.rootWidth = static_cast<std::size_t>(std::stoul(value));
+        } else if (key == "width") {
+            settings.search.nodeWidth = static_cast<std::size_t>(std::stoul(value));
+        } else if (key == "tt") {
+            settings.search.useTranspositionTable = (value != "0");
+        } else if (key == "fresh") {
+            settings.freshTable = (value != "0");
+        } else if (key == "multipv") {
+            settings.multiPv = static_cast<std::size_t>(std::stoul(value));
+        } else if (key == "weights") {
+            ok = settings.weights.Load(value);
+        } else {
+            ok = false;
+        }
+
+        if (!ok || settings.depth <= 0 || settings.winLength <= 0) {
+            std::cerr << "Неверный параметр: " << arg << "\n";
+            return 1;
+        }
+    }
+
+    std::ifstream inFile;
+    if (inPath != "-") {
+        inFile.open(inPath);
+        if (!inFile.is_open()) {
+            std::cerr << "Не удалось открыть " << inPath << "\n";
+            return 1;
+        }
+    }
+    std::ofstream outFile;
+    if (outPath != "-") {
+        outFile.open(outPath);
+        if (!outFile.is_open()) {
+            std::cerr << "Не удалось открыть " << outPath << "\n";
+            return 1;
+        }
+    }
+    std::istream& in = inPath == "-" ? std::cin : inFile;
+    std::ostream& out = outPath == "-" ? std::cout : outFile;
+
+    auto start = std::chrono::steady_clock::now();
+    std::size_t count = BatchAnalyzer::Run(in, out, settings);
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    std::cerr << "Позиций: " << count << ", " << seconds << " с, "
+              << static_cast<double>(count) / seconds << " позиций/с\n";
+    return out ? 0 : 1;
+}
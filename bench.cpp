@@ -0,0 +1,596 @@
+// bench.cpp — набор бенчмарков: хеш-таблица (в том числе конкурентная),
+// динамический массив, генерация ходов, оценка позиции, полный поиск
+// (minimax и MCTS), оценка сетью (NNUE) и чтение файла партий
+//
+// Использование:
+//   bench [--quick] [--filter подстрока] [--json файл] [--csv файл]
+//         [--baseline файл.csv] [--threshold 0.15]
+//
+// С --baseline сравнивает медианы с сохранённым CSV и завершается
+// с кодом 1, если хоть одна выросла больше порога.
+
+#include "Benchmark.hpp"
+#include "ConcurrentHashTable.hpp"
+#include "GameRecord.hpp"
+#include "MctsSearch.hpp"
+#include "NnueNetwork.hpp"
+#include "PositionSuite.hpp"
+#include "TicTacToe.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+static void benchHashTable(BenchmarkRunner& runner) {
+    PositionHash ph;
+    auto hashFunc = [ph](const Position& p) { return ph(p); };
+
+    const int side = 32;    // 1024 ключа в таблице на 1024 корзины
+    DynamicArray<Position> keys;
+    for (int x = 0; x < side; ++x) {
+        for (int y = 0; y < side; ++y) {
+            keys.push_back(Position(x - side / 2, y - side / 2));
+        }
+    }
+
+    runner.Run("hashtable/add_1024", [&]() {
+        HashTable<Position, int> ht(1024, hashFunc);
+        for (const auto& k : keys) {
+            ht.Add(k, 1);
+        }
+        DoNotOptimize(ht.GetCount());
+    }, keys.size());
+
+    HashTable<Position, int> filled(1024, hashFunc);
+    for (const auto& k : keys) {
+        filled.Add(k, 1);
+    }
+
+    runner.Run("hashtable/get_hit", [&]() {
+        int sum = 0;
+        for (const auto& k : keys) {
+            sum += filled.Get(k);
+        }
+        DoNotOptimize(sum);
+    }, keys.size());
+
+    runner.Run("hashtable/contains_miss", [&]() {
+        int found = 0;
+        for (const auto& k : keys) {
+            found += filled.ContainsKey(Position(k.x + 1000, k.y)) ? 1 : 0;
+        }
+        DoNotOptimize(found);
+    }, keys.size());
+
+    runner.Run("hashtable/add_remove", [&]() {
+        for (const auto& k : keys) {
+            Position p(k.x, k.y + 1000);
+            filled.Add(p, 2);
+            filled.Remove(p);
+        }
+    }, keys.size());
+}
+
+// Поштучный поиск против пакетного (ContainsBatch/GetBatch) в таблице
+// на keyCount ключей. Запросы идут в случайном порядке, и их столько,
+// что на большой таблице затронутые корзины не помещаются в кэш.
+static void benchHashTableBatch(BenchmarkRunner& runner,
+                                const std::string& size, int keyCount) {
+    const std::string prefix = "hashtable/batch_" + size;
+    if (!runner.IsSelected(prefix + "/single") &&
+        !runner.IsSelected(prefix + "/contains") &&
+        !runner.IsSelected(prefix + "/get")) {
+        return;
+    }
+
+    PositionHash ph;
+    auto hashFunc = [ph](const Position& p) { return ph(p); };
+
+    const int side = 1024;
+    HashTable<Position, int> table(static_cast<std::size_t>(keyCount),
+                                   hashFunc);
+    for (int i = 0; i < keyCount; ++i) {
+        table.Add(Position(i % side, i / side), i);
+    }
+
+    // Половина запросов — попадания, половина — промахи
+    const std::size_t queryCount = static_cast<std::size_t>(keyCount) / 4;
+    DynamicArray<Position> queries(queryCount);
+    DynamicArray<bool> found(queryCount);
+    DynamicArray<int> values(queryCount);
+    std::uint32_t state = 12345;
+    for (std::size_t i = 0; i < queryCount; ++i) {
+        state = state * 1664525u + 1013904223u;
+        int k = static_cast<int>((state >> 8) % static_cast<std::uint32_t>(keyCount));
+        int y = k / side + ((i & 1) ? 0 : keyCount / side + 1);
+        queries.push_back(Position(k % side, y));
+        found.push_back(false);
+        values.push_back(0);
+    }
+
+    runner.Run(prefix + "/single", [&]() {
+        int hits = 0;
+        for (const auto& q : queries) {
+            hits += table.ContainsKey(q) ? 1 : 0;
+        }
+        DoNotOptimize(hits);
+    }, queryCount);
+
+    runner.Run(prefix + "/contains", [&]() {
+        table.ContainsBatch(queries.begin(), queryCount, found.begin());
+        DoNotOptimize(found[queryCount - 1]);
+    }, queryCount);
+
+    runner.Run(prefix + "/get", [&]() {
+        DoNotOptimize(table.GetBatch(queries.begin(), queryCount,
+                                     values.begin(), found.begin()));
+    }, queryCount);
+}
+
+static void benchDynamicArray(BenchmarkRunner& runner) {
+    const std::size_t n = 4096;
+
+    runner.Run("dynamicarray/push_back_grow", [&]() {
+        DynamicArray<int> a;
+        for (std::size_t i = 0; i < n; ++i) {
+            a.push_back(static_cast<int>(i));
+        }
+        DoNotOptimize(a.size());
+    }, n);
+
+    runner.Run("dynamicarray/push_back_reserved", [&]() {
+        DynamicArray<int> a;
+        a.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            a.push_back(static_cast<int>(i));
+        }
+        DoNotOptimize(a.size());
+    }, n);
+
+    runner.Run("dynamicarray/push_back_position_grow", [&]() {
+        DynamicArray<Position> a;
+        for (std::size_t i = 0; i < n; ++i) {
+            a.push_back(Position(static_cast<int>(i), 0));
+        }
+        DoNotOptimize(a.size());
+    }, n);
+}
+
+// HashTable под одним общим мьютексом — то, что пришлось бы делать
+// без ConcurrentHashTable
+template<typename TKey, typename TValue>
+class LockedHashTable {
+private:
+    HashTable<TKey, TValue> table_;
+    mutable std::mutex mutex_;
+
+public:
+    LockedHashTable(std::size_t capacity,
+                    std::function<std::size_t(const TKey&)> hash)
+        : table_(capacity, std::move(hash)) {}
+
+    void Add(const TKey& key, const TValue& value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        table_.Add(key, value);
+    }
+
+    [[nodiscard]] bool ContainsKey(const TKey& key) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return table_.ContainsKey(key);
+    }
+};
+
+// Пропускная способность при 90% чтений / 10% записей.
+// Время — на одну операцию суммарно по всем потокам.
+template<typename Table>
+static void benchConcurrentTable(BenchmarkRunner& runner,
+                                 const std::string& name, Table& table,
+                                 int threads) {
+    const int opsPerThread = 20000;
+    runner.Run(name + "/t" + std::to_string(threads), [&]() {
+        DynamicArray<std::thread> pool;
+        for (int t = 0; t < threads; ++t) {
+            pool.push_back(std::thread([&table, t]() {
+                int hits = 0;
+                for (int i = 0; i < opsPerThread; ++i) {
+                    Position p((i * 7 + t) & 1023, (i >> 10) & 7);
+                    if (i % 10 == 0) {
+                        table.Add(p, i);
+                    } else {
+                        hits += table.ContainsKey(p) ? 1 : 0;
+                    }
+                }
+                DoNotOptimize(hits);
+            }));
+        }
+        for (auto& th : pool) {
+            th.join();
+        }
+    }, static_cast<std::size_t>(opsPerThread) * threads);
+}
+
+// Только чтения: масштабирование поиска по числу потоков. Потоки
+// создаются до замера и ждут старта на барьере, так что в замер попадают
+// лишь сами поиски, без создания и завершения потоков.
+// Время — на одну операцию суммарно по всем потокам.
+template<typename Table>
+static void benchConcurrentReads(BenchmarkRunner& runner,
+                                 const std::string& name, const Table& table,
+                                 int threads) {
+    const std::string fullName = name + "/t" + std::to_string(threads);
+    if (!runner.IsSelected(fullName)) {
+        return;
+    }
+
+    const int opsPerThread = 20000;
+    std::atomic<unsigned> generation(0);
+    std::atomic<int> done(0);
+    std::atomic<bool> stop(false);
+
+    DynamicArray<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.push_back(std::thread([&, t]() {
+            unsigned seen = 0;
+            for (;;) {
+                unsigned g;
+                while ((g = generation.load(std::memory_order_acquire)) == seen &&
+                       !stop.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                if (g == seen) {
+                    return;
+                }
+                seen = g;
+
+                int hits = 0;
+                for (int i = 0; i < opsPerThread; ++i) {
+                    Position p((i * 7 + t) & 1023, (i >> 10) & 7);
+                    hits += table.ContainsKey(p) ? 1 : 0;
+                }
+                DoNotOptimize(hits);
+                done.fetch_add(1, std::memory_order_release);
+            }
+        }));
+    }
+
+    runner.Run(fullName, [&]() {
+        done.store(0, std::memory_order_relaxed);
+        generation.fetch_add(1, std::memory_order_release);
+        while (done.load(std::memory_order_acquire) != threads) {
+            std::this_thread::yield();
+        }
+    }, static_cast<std::size_t>(opsPerThread) * threads);
+
+    stop.store(true, std::memory_order_release);
+    for (auto& th : pool) {
+        th.join();
+    }
+}
+
+static void benchConcurrent(BenchmarkRunner& runner) {
+    PositionHash ph;
+    auto hashFunc = [ph](const Position& p) { return ph(p); };
+
+    LockedHashTable<Position, int> locked(1024, hashFunc);
+    ConcurrentHashTable<Position, int> sharded(8192, hashFunc, 16);
+
+    for (int threads = 1; threads <= 8; threads *= 2) {
+        benchConcurrentTable(runner, "concurrent/mutex_hashtable", locked,
+                             threads);
+        benchConcurrentTable(runner, "concurrent/sharded_hashtable", sharded,
+                             threads);
+    }
+
+    // Для чтений таблицы заполнены заранее: половина ключей есть
+    LockedHashTable<Position, int> lockedRead(4096, hashFunc);
+    ConcurrentHashTable<Position, int> shardedRead(8192, hashFunc, 16);
+    for (int x = 0; x < 1024; x += 2) {
+        for (int y = 0; y < 8; ++y) {
+            lockedRead.Add(Position(x, y), x + y);
+            shardedRead.Add(Position(x, y), x + y);
+        }
+    }
+
+    for (int threads = 1; threads <= 8; threads *= 2) {
+        benchConcurrentReads(runner, "concurrent/mutex_hashtable_read",
+                             lockedRead, threads);
+        benchConcurrentReads(runner, "concurrent/sharded_hashtable_read",
+                             shardedRead, threads);
+    }
+}
+
+static void benchGame(BenchmarkRunner& runner, bool quick) {
+    std::size_t count = 0;
+    const SuitePosition* suite = GetPositionSuite(count);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::string name = suite[i].name;
+
+        DynamicArray<Position> moves;
+        TicTacToeGame game(5);
+        // Маленькая таблица транспозиций: её очистка перед каждым поиском
+        // не должна заметно влиять на замер
+        game.SetTranspositionTableSize(1 << 10);
+        Cell toMove = EMPTY;
+        if (ParseMoveList(suite[i].moves, moves)) {
+            toMove = PlayMoveList(game, moves);
+        }
+        if (toMove == EMPTY) {
+            std::cout << "Некорректная позиция в наборе: " << name << "\n";
+            continue;
+        }
+
+        runner.Run("movegen/" + name, [&]() {
+            DoNotOptimize(game.GetPossibleMoves().size());
+        });
+
+        runner.Run("eval/" + name, [&]() {
+            DoNotOptimize(game.EvaluatePosition(toMove));
+        });
+
+        runner.Run("checkwin/" + name, [&]() {
+            DoNotOptimize(game.CheckWin(toMove));
+        });
+
+        // Ядра SearchState: длина линии из поля против константы
+        PositionHash ph;
+        HashTable<Position, Cell> board(
+            64, [ph](const Position& p) { return ph(p); });
+        for (const auto& s : game.GetStones()) {
+            board.Add(s.pos, s.cell);
+        }
+        SearchState state;
+        state.Load(board, 5, 1);
+
+        runner.Run("kernel_eval/" + name + "/runtime", [&]() {
+            DoNotOptimize(state.EvaluateScanFixed<0>(toMove));
+        });
+        runner.Run("kernel_eval/" + name + "/fixed5", [&]() {
+            DoNotOptimize(state.EvaluateScanFixed<5>(toMove));
+        });
+        runner.Run("kernel_checkwin/" + name + "/runtime", [&]() {
+            DoNotOptimize(state.CheckWinFixed<0>(toMove));
+        });
+        runner.Run("kernel_checkwin/" + name + "/fixed5", [&]() {
+            DoNotOptimize(state.CheckWinFixed<5>(toMove));
+        });
+
+        // Таблица транспозиций очищается, иначе повторы меряли бы
+        // «прогретый» поиск
+        const int maxDepth = quick ? 2 : 3;
+        for (int depth = 1; depth <= maxDepth; ++depth) {
+            runner.Run("search/" + name + "/d" + std::to_string(depth),
+                       [&]() {
+                game.ClearTranspositionTable();
+                DoNotOptimize(game.FindBestMove(toMove, depth));
+            });
+        }
+
+        // То же с длиной линии, известной при компиляции
+        BasicTicTacToeGame<5> fixedGame;
+        fixedGame.SetTranspositionTableSize(1 << 10);
+        PlayMoveList(fixedGame, moves);
+        for (int depth = 1; depth <= maxDepth; ++depth) {
+            runner.Run("search_fixed5/" + name + "/d" + std::to_string(depth),
+                       [&]() {
+                fixedGame.ClearTranspositionTable();
+                DoNotOptimize(fixedGame.FindBestMove(toMove, depth));
+            });
+        }
+
+        // MCTS с нуля, время на один плейаут
+        MctsSettings mctsSettings;
+        mctsSettings.iterations = quick ? 500 : 2000;
+        mctsSettings.reuseTree = false;
+        MctsSearch mcts(mctsSettings);
+        runner.Run("mcts/" + name, [&]() {
+            DoNotOptimize(mcts.FindBestMove(game, toMove));
+        }, static_cast<std::size_t>(mctsSettings.iterations));
+    }
+}
+
+// Оценка сетью против оценки по линиям: сама оценка (векторное и
+// скалярное ядро), узел поиска — ход, оценка, отмена — и полный поиск.
+// В конце — оценок в секунду.
+static void benchNnue(BenchmarkRunner& runner, bool quick) {
+    std::size_t count = 0;
+    const SuitePosition* suite = GetPositionSuite(count);
+    NnueNetwork net = NnueNetwork::CreatePattern(5);
+    NnueNetwork scalar = net;
+    scalar.SetUseSimd(false);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::string name = suite[i].name;
+
+        DynamicArray<Position> moves;
+        TicTacToeGame game(5);
+        game.SetTranspositionTableSize(1 << 10);
+        Cell toMove = EMPTY;
+        if (ParseMoveList(suite[i].moves, moves)) {
+            toMove = PlayMoveList(game, moves);
+        }
+        if (toMove == EMPTY) {
+            continue;
+        }
+
+        DynamicArray<Stone> stones = game.GetStones();
+        SearchState lines;
+        lines.Load(stones, 5, 2);
+        SearchState nnue;
+        nnue.SetNetwork(&net);
+        nnue.Load(stones, 5, 2);
+        SearchState nnueScalar;
+        nnueScalar.SetNetwork(&scalar);
+        nnueScalar.Load(stones, 5, 2);
+
+        runner.Run("nnue_eval/" + name + "/simd", [&]() {
+            DoNotOptimize(nnue.EvaluateNnue(toMove));
+        });
+        runner.Run("nnue_eval/" + name + "/scalar", [&]() {
+            DoNotOptimize(nnueScalar.EvaluateNnue(toMove));
+        });
+
+        // Копия кандидатов: буфер уровня 0 перезаписывается
+        DynamicArray<Position> candidates(lines.GenerateMoves(0));
+        const Cell opponent = (toMove == X) ? O : X;
+        runner.Run("node_eval/" + name + "/lines", [&]() {
+            for (const auto& m : candidates) {
+                lines.MakeMove(m, toMove);
+                DoNotOptimize(lines.Evaluate(opponent));
+                lines.UndoMove();
+            }
+        }, candidates.size());
+        // То же полным обходом: ступени Evaluate против прежнего ядра
+        runner.Run("node_eval/" + name + "/scan", [&]() {
+            for (const auto& m : candidates) {
+                lines.MakeMove(m, toMove);
+                DoNotOptimize(lines.EvaluateScanFixed<5>(opponent));
+                lines.UndoMove();
+            }
+        }, candidates.size());
+        runner.Run("node_eval/" + name + "/nnue", [&]() {
+            for (const auto& m : candidates) {
+                nnue.MakeMove(m, toMove);
+                DoNotOptimize(nnue.EvaluateNnue(opponent));
+                nnue.UndoMove();
+            }
+        }, candidates.size());
+
+        game.SetEvaluator(&net);
+        const int maxDepth = quick ? 2 : 3;
+        for (int depth = 1; depth <= maxDepth; ++depth) {
+            runner.Run("search_nnue/" + name + "/d" + std::to_string(depth),
+                       [&]() {
+                game.ClearTranspositionTable();
+                DoNotOptimize(game.FindBestMove(toMove, depth));
+            });
+        }
+    }
+
+    for (const auto& r : runner.GetResults()) {
+        if (r.name.rfind("nnue_eval/", 0) == 0 ||
+            r.name.rfind("node_eval/", 0) == 0) {
+            std::cout << r.name << ": " << 1e9 / r.medianNs
+                      << " оценок/с\n";
+        }
+    }
+}
+
+// Файл из gameCount партий по 30 полуходов: декодирование всех ходов
+// и расстановка каждой партии на доске
+static void benchRecords(BenchmarkRunner& runner) {
+    if (!runner.IsSelected("records/decode") &&
+        !runner.IsSelected("records/replay")) {
+        return;
+    }
+
+    const char* path = "bench_games.tttg";
+    const std::size_t gameCount = 10000;
+    std::remove(path);      // писатель дописывает в существующий файл
+    {
+        GameRecordWriter writer;
+        if (!writer.Open(path)) {
+            std::cerr << "Не удалось создать " << path << "\n";
+            return;
+        }
+        DynamicArray<Position> moves(30);
+        for (std::size_t g = 0; g < gameCount; ++g) {
+            moves.clear();
+            int shift = static_cast<int>(g % 7);
+            for (int i = 0; i < 30; ++i) {
+                moves.push_back(Position(i % 6 + shift, i / 6 - shift));
+            }
+            writer.Append(moves, 5, (g % 3 == 0) ? EMPTY : X);
+        }
+    }
+
+    GameRecordReader reader;
+    if (!reader.Open(path)) {
+        std::cerr << "Не удалось открыть " << path << "\n";
+        return;
+    }
+
+    runner.Run("records/decode", [&]() {
+        long long sum = 0;
+        for (std::size_t g = 0; g < reader.GetGameCount(); ++g) {
+            reader.GetGame(g).ForEachMove([&sum](const Position& m, Cell) {
+                sum += m.x + m.y;
+            });
+        }
+        DoNotOptimize(sum);
+    }, gameCount);
+
+    TicTacToeGame game(5);
+    runner.Run("records/replay", [&]() {
+        for (std::size_t g = 0; g < reader.GetGameCount(); ++g) {
+            DoNotOptimize(reader.Replay(g, game));
+        }
+    }, gameCount);
+
+    reader.Close();
+    std::remove(path);
+}
+
+int main(int argc, char** argv) {
+    bool quick = false;
+    std::string filter;
+    std::string jsonPath;
+    std::string csvPath;
+    std::string baselinePath;
+    double threshold = 0.15;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--quick") {
+            quick = true;
+        } else if (arg == "--filter" && hasValue) {
+            filter = argv[++i];
+        } else if (arg == "--json" && hasValue) {
+            jsonPath = argv[++i];
+        } else if (arg == "--csv" && hasValue) {
+            csvPath = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            baselinePath = argv[++i];
+        } else if (arg == "--threshold" && hasValue) {
+            threshold = std::stod(argv[++i]);
+        } else {
+            std::cerr << "Неизвестный параметр: " << arg << "\n";
+            return 2;
+        }
+    }
+
+    BenchmarkRunner runner = quick ? BenchmarkRunner(7, 1, 5e5)
+                                   : BenchmarkRunner();
+    runner.SetFilter(filter);
+
+    benchHashTable(runner);
+    benchHashTableBatch(runner, "1k", 1 << 10);
+    benchHashTableBatch(runner, "4m", 1 << 22);
+    benchDynamicArray(runner);
+    benchConcurrent(runner);
+    benchGame(runner, quick);
+    benchNnue(runner, quick);
+    benchRecords(runner);
+
+    if (!jsonPath.empty() && !runner.WriteJson(jsonPath)) {
+        std::cerr << "Не удалось записать " << jsonPath << "\n";
+        return 2;
+    }
+    if (!csvPath.empty() && !runner.WriteCsv(csvPath)) {
+        std::cerr << "Не удалось записать " << csvPath << "\n";
+        return 2;
+    }
+
+    if (!baselinePath.empty()) {
+        int regressions = runner.CompareWithBaseline(baselinePath, threshold);
+        if (regressions != 0) {
+            std::cout << "Обнаружены регрессии производительности\n";
+            return 1;
+        }
+    }
+    return 0;
+}
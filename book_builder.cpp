@@ -0,0 +1,157 @@
+// book_builder.cpp — построение дебютной книги из партий ИИ против ИИ
+//
+// Использование:
+//   book_builder [файл=opening.book] [партий=200] [глубина=2] [полуходов=8]
+//                [партии.tttg]
+//
+// Если указан файл партий (GameRecord.hpp), книга строится по записанным
+// в нём партиям, а не по новым; «партий» и «глубина» тогда не нужны.
+
+#include "TicTacToe.hpp"
+#include "OpeningBook.hpp"
+#include "GameRecord.hpp"
+
+#include <iostream>
+#include <random>
+#include <string>
+
+// Длина линии партий; записывается в заголовок книги
+static constexpr int kWinLength = 5;
+
+struct PendingMove {
+    DynamicArray<Stone> stones;
+    Cell player;
+    Position move;
+};
+
+// Книга по записанным партиям: каждая партия расставляется заново
+// на одной и той же доске
+static bool recordFromFile(const std::string& path, int maxPlies,
+                           OpeningBookBuilder& builder,
+                           int& xWins, int& oWins, int& draws) {
+    GameRecordReader reader;
+    if (!reader.Open(path)) {
+        std::cerr << "Не удалось открыть файл партий " << path << "\n";
+        return false;
+    }
+
+    TicTacToeGame game(kWinLength);
+    std::size_t skipped = 0;
+    for (std::size_t g = 0; g < reader.GetGameCount(); ++g) {
+        GameRecordView view = reader.GetGame(g);
+        if (view.GetWinLength() != game.GetWinLength()) {
+            ++skipped;
+            continue;
+        }
+
+        Cell winner = view.GetWinner();
+        ++(winner == X ? xWins : winner == O ? oWins : draws);
+        int ply = 0;
+        game.Reset();
+        view.ForEachMove([&](const Position& move, Cell player) {
+            if (ply++ >= maxPlies) {
+                return;
+            }
+            int result = (winner == EMPTY) ? 0
+                       : (winner == player ? 1 : -1);
+            builder.Record(game.GetStones(), player, move, result);
+            game.MakeMove(move.x, move.y, player);
+        });
+    }
+
+    std::cout << "Партий из " << path << ": "
+              << reader.GetGameCount() - skipped << "\n";
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::string path = (argc > 1) ? argv[1] : "opening.book";
+    int games    = (argc > 2) ? std::stoi(argv[2]) : 200;
+    int depth    = (argc > 3) ? std::stoi(argv[3]) : 2;
+    int maxPlies = (argc > 4) ? std::stoi(argv[4]) : 8;
+
+    const int maxMoves = 40;
+    const int openingRandomMovesLimit = 2;
+
+    OpeningBookBuilder builder;
+    std::mt19937 rng(12345);
+
+    int xWins = 0, oWins = 0, draws = 0;
+
+    if (argc > 5) {
+        if (!recordFromFile(argv[5], maxPlies, builder,
+                            xWins, oWins, draws)) {
+            return 1;
+        }
+        games = 0;
+    }
+
+    for (int g = 0; g < games; ++g) {
+        TicTacToeGame game(kWinLength);
+        DynamicArray<PendingMove> pending;
+        Cell winner = EMPTY;
+        bool xTurn = true;
+
+        for (int moveIndex = 0; moveIndex < maxMoves; ++moveIndex) {
+            Cell player = xTurn ? X : O;
+            Position move;
+
+            if (moveIndex < openingRandomMovesLimit) {
+                // Случайное начало, как в demoMode
+                DynamicArray<Position> moves = game.GetPossibleMoves();
+                std::uniform_int_distribution<int> dist(
+                    0, static_cast<int>(moves.size()) - 1);
+                move = moves[static_cast<std::size_t>(dist(rng))];
+            } else {
+                move = game.FindBestMove(player, depth);
+            }
+
+            if (moveIndex < maxPlies) {
+                PendingMove pm;
+                pm.stones = game.GetStones();
+                pm.player = player;
+                pm.move = move;
+                pending.push_back(std::move(pm));
+            }
+
+            game.MakeMove(move.x, move.y, player);
+
+            if (game.CheckWin(player)) {
+                winner = player;
+                break;
+            }
+            xTurn = !xTurn;
+        }
+
+        if (winner == X) {
+            ++xWins;
+        } else if (winner == O) {
+            ++oWins;
+        } else {
+            ++draws;
+        }
+
+        for (const auto& pm : pending) {
+            int result = (winner == EMPTY) ? 0
+                       : (winner == pm.player ? 1 : -1);
+            builder.Record(pm.stones, pm.player, pm.move, result);
+        }
+
+        if ((g + 1) % 10 == 0) {
+            std::cout << "Сыграно партий: " << (g + 1) << "/" << games << "\n";
+        }
+    }
+
+    if (!builder.Write(path, maxPlies, kWinLength)) {
+        std::cerr << "Не удалось записать книгу в " << path << "\n";
+        return 1;
+    }
+
+    OpeningBook book;
+    book.Open(path);
+    std::cout << "Книга записана: " << path << "\n";
+    std::cout << "  Позиций-ходов: " << book.GetEntryCount() << "\n";
+    std::cout << "  X/O/ничьи: " << xWins << "/" << oWins << "/" << draws
+              << "\n";
+    return 0;
+}
@@ -0,0 +1,23 @@
+// gomocup.cpp — движок для оболочек piskvork / Gomocup (протокол через
+// stdin/stdout, см. GomocupProtocol.hpp)
+//
+// Использование: положить собранный файл под именем pbrain-laba2
+// в папку движков оболочки либо вести диалог вручную:
+//   START 15
+//   BEGIN
+//   TURN 7,8
+//   END
+//
+// Необязательный аргумент — файл весов оценки (по умолчанию
+// eval.weights в текущей папке); он перечитывается перед каждой
+// партией, если изменился.
+
+#include "GomocupProtocol.hpp"
+
+#include <iostream>
+
+int main(int argc, char** argv) {
+    GomocupEngine engine(argc > 1 ? argv[1] : "eval.weights");
+    engine.Run(std::cin, std::cout);
+    return 0;
+}
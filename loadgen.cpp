@@ -0,0 +1,203 @@
+// loadgen.cpp — нагрузочный тест SessionHost: много одновременных партий
+// против случайного соперника, пропускная способность и задержка хода
+//
+// Использование (все параметры необязательны):
+//   loadgen sessions=10,100,1000 workers=0 moves=10 limit=50 depth=4 seed=1
+//
+// Для каждого числа сессий печатает ходов в секунду, p50/p99 задержки
+// хода (от запроса до ответа, с ожиданием в очереди), долю ответов позже
+// срока и память на сессию.
+
+#include "SessionHost.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+
+struct LoadSettings {
+    DynamicArray<int> sessionCounts;
+    std::size_t workers = 0;
+    int moves = 10;             // ходов движка в каждой партии
+    int limitMs = 50;           // срок на ход
+    int depth = 4;
+    std::uint32_t seed = 1;
+};
+
+struct LoadReport {
+    long long moves = 0;
+    double seconds = 0.0;
+    double p50Ms = 0.0;
+    double p99Ms = 0.0;
+    long long missed = 0;
+    std::size_t memoryPerSession = 0;
+};
+
+// Случайная пустая клетка рядом с одним из камней
+static Position randomReply(const DynamicArray<Stone>& stones,
+                            std::mt19937& rng) {
+    if (stones.empty()) {
+        return Position(0, 0);
+    }
+    std::uniform_int_distribution<std::size_t> pick(0, stones.size() - 1);
+    std::uniform_int_distribution<int> offset(-1, 1);
+    for (int attempt = 0; attempt < 32; ++attempt) {
+        const Position& base = stones[pick(rng)].pos;
+        Position p(base.x + offset(rng), base.y + offset(rng));
+        bool occupied = false;
+        for (const auto& s : stones) {
+            if (s.pos == p) {
+                occupied = true;
+                break;
+            }
+        }
+        if (!occupied) {
+            return p;
+        }
+    }
+    return Position(static_cast<int>(stones.size()) * 3, 1000);
+}
+
+static LoadReport runLoad(const LoadSettings& settings, int sessionCount) {
+    // Объявлены до host: последний callback ещё держит mutex, когда
+    // runLoad уже проснулся, а деструктор host дожидается рабочих потоков
+    std::mutex mutex;
+    std::condition_variable finished;
+    int activeSessions = sessionCount;
+
+    SessionHost host(settings.workers, settings.depth);
+    const auto limit = std::chrono::milliseconds(settings.limitMs);
+
+    DynamicArray<SessionHost::SessionId> ids;
+    DynamicArray<std::mt19937> rngs;
+    DynamicArray<int> movesLeft;
+    for (int i = 0; i < sessionCount; ++i) {
+        ids.push_back(host.CreateSession());
+        rngs.push_back(std::mt19937(settings.seed + static_cast<std::uint32_t>(i)));
+        movesLeft.push_back(settings.moves);
+    }
+
+    DynamicArray<double> latencies;
+    latencies.reserve(static_cast<std::size_t>(sessionCount) *
+                      static_cast<std::size_t>(settings.moves));
+    long long missed = 0;
+
+    // Ответ движка: записать задержку, сходить за соперника, запросить
+    // следующий ход
+    std::function<void(const SessionHost::MoveResult&)> onMove;
+    onMove = [&](const SessionHost::MoveResult& r) {
+        std::size_t index = static_cast<std::size_t>(r.session - ids[0]);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            latencies.push_back(r.latencyMs);
+            missed += r.deadlineMissed ? 1 : 0;
+        }
+        if (--movesLeft[index] > 0) {
+            Position reply = randomReply(host.GetStones(r.session),
+                                         rngs[index]);
+            if (host.Play(r.session, reply.x, reply.y, X) &&
+                host.RequestMove(r.session, O, limit, onMove)) {
+                return;
+            }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--activeSessions == 0) {
+            finished.notify_one();
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+        host.Play(ids[i], 0, 0, X);
+        host.RequestMove(ids[i], O, limit, onMove);
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [&]() { return activeSessions == 0; });
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    LoadReport report;
+    report.moves = static_cast<long long>(latencies.size());
+    report.seconds = std::chrono::duration<double>(end - start).count();
+    report.missed = missed;
+    std::sort(latencies.begin(), latencies.end());
+    if (!latencies.empty()) {
+        report.p50Ms = latencies[latencies.size() / 2];
+        report.p99Ms = latencies[std::min(latencies.size() - 1,
+                                          latencies.size() * 99 / 100)];
+    }
+    report.memoryPerSession =
+        host.GetTotalSessionMemory() / static_cast<std::size_t>(sessionCount);
+    return report;
+}
+
+static bool parseCounts(const std::string& text, DynamicArray<int>& counts) {
+    counts.clear();
+    std::istringstream in(text);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        int count = std::stoi(item);
+        if (count <= 0) {
+            return false;
+        }
+        counts.push_back(count);
+    }
+    return !counts.empty();
+}
+
+int main(int argc, char** argv) {
+    LoadSettings settings;
+    parseCounts("10,100,1000", settings.sessionCounts);
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::size_t eq = arg.find('=');
+        if (eq == std::string::npos) {
+            std::cerr << "Ожидался параметр вида ключ=значение: " << arg << "\n";
+            return 1;
+        }
+        std::string key = arg.substr(0, eq);
+        std::string value = arg.substr(eq + 1);
+
+        bool ok = true;
+        if (key == "sessions") {
+            ok = parseCounts(value, settings.sessionCounts);
+        } else if (key == "workers") {
+            settings.workers = static_cast<std::size_t>(std::stoul(value));
+        } else if (key == "moves") {
+            settings.moves = std::stoi(value);
+        } else if (key == "limit") {
+            settings.limitMs = std::stoi(value);
+        } else if (key == "depth") {
+            settings.depth = std::stoi(value);
+        } else if (key == "seed") {
+            settings.seed = static_cast<std::uint32_t>(std::stoul(value));
+        } else {
+            ok = false;
+        }
+
+        if (!ok || settings.moves <= 0) {
+            std::cerr << "Неверный параметр: " << arg << "\n";
+            return 1;
+        }
+    }
+
+    std::cout << "сессий,ходов,с,ходов/с,p50(мс),p99(мс),позже срока(%),"
+                 "память/сессию(байт)\n";
+    for (int count : settings.sessionCounts) {
+        LoadReport r = runLoad(settings, count);
+        std::cout << count << ',' << r.moves << ',' << r.seconds << ','
+                  << r.moves / r.seconds << ',' << r.p50Ms << ','
+                  << r.p99Ms << ','
+                  << 100.0 * static_cast<double>(r.missed) /
+                         static_cast<double>(r.moves)
+                  << ',' << r.memoryPerSession << "\n";
+    }
+    return 0;
+}
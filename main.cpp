@@ -2,6 +2,8 @@
 // Стиль кода согласован с ЛР-3, но логика задачи И-13/И-13.1 сохранена.
 
 #include "TicTacToe.hpp"
+#include "AsyncSearch.hpp"
+#include "GameRecord.hpp"
 
 #include <iostream>
 #include <chrono>
@@ -67,12 +69,36 @@ static void printBoardWindow(const TicTacToeGame& game,
     }
 }
 
+// Дебютная книга (строится утилитой book_builder), общая для всех партий.
+// Если файла нет — ИИ просто считает дебют с нуля.
+static const OpeningBook* openingBook() {
+    static OpeningBook book;
+    static bool tried = false;
+    if (!tried) {
+        tried = true;
+        book.Open("opening.book");
+    }
+    return book.IsOpen() ? &book : nullptr;
+}
+
+// Сыгранные партии дописываются в двоичный файл партий — из него
+// строятся дебютные книги (book_builder)
+static void recordGame(const DynamicArray<Position>& moves, Cell winner) {
+    const char* path = "games.tttg";
+    GameRecordWriter writer;
+    if (!writer.Open(path) || !writer.Append(moves, 5, winner) ||
+        !writer.Close()) {
+        std::cout << "Не удалось сохранить партию в " << path << "\n";
+    }
+}
+
 // === Режим: человек против компьютера ===
 void playHumanVsAI() {
     std::cout << "\n=== Игра «Крестики-нолики» на бесконечном поле ===\n";
     std::cout << "Условие победы: 5 в ряд\n";
 
     TicTacToeGame game(5);
+    game.SetOpeningBook(openingBook());
 
     // Выбор стороны
     std::cout << "\nЗа кого хотите играть?\n";
@@ -95,19 +121,34 @@ void playHumanVsAI() {
     int minX = -5, maxX = 5;
     int minY = -5, maxY = 5;
 
+    // Пока человек думает, компьютер обдумывает ответ на его
+    // предполагаемый ход в фоновом потоке
+    AsyncSearch ponder;
+    bool pondering = false;
+    Position lastHumanMove;
+    DynamicArray<Position> played;
+    Cell winner = EMPTY;
+
     while (true) {
         printBoardWindow(game, minX, maxX, minY, maxY);
 
         if (game.CheckWin(humanCell)) {
             std::cout << "\n*** Вы победили! ***\n";
+            winner = humanCell;
             break;
         }
         if (game.CheckWin(aiCell)) {
             std::cout << "\n*** Компьютер победил! ***\n";
+            winner = aiCell;
             break;
         }
 
         if (humanTurn) {
+            if (!pondering) {
+                ponder.StartPonder(game, humanCell, aiCell, 3);
+                pondering = true;
+            }
+
             std::cout << "\nВаш ход (" << (humanCell == X ? 'X' : 'O')
                       << "). Введите координаты (x y): ";
             int x, y;
@@ -120,10 +161,12 @@ void playHumanVsAI() {
             }
 
             if (!game.MakeMove(x, y, humanCell)) {
-                std::cout << "Некорректный ход! Клетка уже занята. "
-                             "Попробуйте снова.\n";
+                std::cout << "Некорректный ход! Клетка занята или "
+                             "вне поля. Попробуйте снова.\n";
                 continue;
             }
+            lastHumanMove = Position(x, y);
+            played.push_back(lastHumanMove);
 
             minX = std::min(minX, x - 2);
             maxX = std::max(maxX, x + 2);
@@ -134,7 +177,22 @@ void playHumanVsAI() {
                       << (aiCell == X ? 'X' : 'O') << ")...\n";
 
             auto start = std::chrono::high_resolution_clock::now();
-            Position aiMove = game.FindBestMove(aiCell, 3);
+            Position aiMove;
+            long long nodes = 0;
+            bool ponderHit = pondering &&
+                             ponder.PonderHit(lastHumanMove, aiMove) &&
+                             game.GetCell(aiMove.x, aiMove.y) == EMPTY;
+            if (pondering) {
+                // Таблица транспозиций, прогретая обдумыванием
+                game.AdoptTranspositionTable(ponder.GetGame());
+                pondering = false;
+            }
+            if (ponderHit) {
+                nodes = ponder.GetGame().GetNodesEvaluated();
+            } else {
+                aiMove = game.FindBestMove(aiCell, 3);
+                nodes = game.GetNodesEvaluated();
+            }
             auto end = std::chrono::high_resolution_clock::now();
 
             auto duration =
@@ -142,12 +200,13 @@ void playHumanVsAI() {
                     end - start);
 
             game.MakeMove(aiMove.x, aiMove.y, aiCell);
+            played.push_back(aiMove);
 
             std::cout << "Компьютер сделал ход: ("
                       << aiMove.x << ", " << aiMove.y << ")\n";
-            std::cout << "Время вычисления: " << duration.count() << " мс\n";
-            std::cout << "Узлов оценено: "
-                      << game.GetNodesEvaluated() << "\n";
+            std::cout << "Время вычисления: " << duration.count() << " мс"
+                      << (ponderHit ? " (ход угадан заранее)" : "") << "\n";
+            std::cout << "Узлов оценено: " << nodes << "\n";
 
             minX = std::min(minX, aiMove.x - 2);
             maxX = std::max(maxX, aiMove.x + 2);
@@ -159,6 +218,7 @@ void playHumanVsAI() {
     }
 
     printBoardWindow(game, minX, maxX, minY, maxY);
+    recordGame(played, winner);
 }
 
 // === Режим: человек против человека ===
@@ -198,8 +258,8 @@ void playHumanVsHuman() {
         }
 
         if (!game.MakeMove(x, y, current)) {
-            std::cout << "Некорректный ход! Клетка уже занята. "
-                         "Попробуйте снова.\n";
+            std::cout << "Некорректный ход! Клетка занята или "
+                         "вне поля. Попробуйте снова.\n";
             continue;
         }
 
@@ -224,7 +284,9 @@ void compareAlgorithms() {
         return;
     }
 
-    csv << "Глубина,Время(мс),Узлов оценено\n";
+    csv << "Глубина,Время(мс),Узлов оценено,";
+    SearchStats::WriteCsvHeader(csv);
+    csv << "\n";
 
     for (int depth = 1; depth <= 4; ++depth) {
         TicTacToeGame game(5);
@@ -243,13 +305,29 @@ void compareAlgorithms() {
             std::chrono::duration_cast<std::chrono::milliseconds>(
                 end - start);
         long long nodes = game.GetNodesEvaluated();
+        const SearchStats& stats = game.GetSearchStats();
 
         std::cout << "Глубина " << depth << ":\n";
         std::cout << "  Время: " << duration.count() << " мс\n";
         std::cout << "  Узлов оценено: " << nodes << "\n";
+        if (SearchStats::kEnabled) {
+            std::cout << "  Узлов дерева: " << stats.nodes
+                      << ", листьев: " << stats.leafEvaluations
+                      << ", отсечений: " << stats.cutoffs
+                      << " (первым ходом "
+                      << stats.FirstMoveCutoffRate() * 100 << "%)\n";
+            std::cout << "  Эффективное ветвление: "
+                      << stats.EffectiveBranchingFactor() << "\n";
+            std::cout << "  Время: генерация ходов "
+                      << stats.moveGenNs / 1000000 << " мс, оценка "
+                      << stats.evalNs / 1000000 << " мс, проверка победы "
+                      << stats.winCheckNs / 1000000 << " мс\n";
+        }
         std::cout << "  Лучший ход: (" << move.x << ", " << move.y << ")\n\n";
 
-        csv << depth << "," << duration.count() << "," << nodes << "\n";
+        csv << depth << "," << duration.count() << "," << nodes << ",";
+        stats.WriteCsvRow(csv);
+        csv << "\n";
     }
 
     csv.close();
@@ -280,6 +358,7 @@ void demoMode() {
     std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
 
     TicTacToeGame game(5);
+    game.SetOpeningBook(openingBook());
     int minX = -5, maxX = 5;
     int minY = -5, maxY = 5;
     bool xTurn = true;
@@ -289,15 +368,20 @@ void demoMode() {
     int openingRandomMovesDone  = 0;
     int openingRandomMovesLimit = 2;   // 2 первых хода — случайные
 
+    DynamicArray<Position> played;
+    Cell winner = EMPTY;
+
     for (int moveIndex = 0; moveIndex < 40; ++moveIndex) {
         printBoardWindow(game, minX, maxX, minY, maxY);
 
         if (game.CheckWin(X)) {
             std::cout << "\n*** X победил! ***\n";
+            winner = X;
             break;
         }
         if (game.CheckWin(O)) {
             std::cout << "\n*** O победил! ***\n";
+            winner = O;
             break;
         }
 
@@ -330,6 +414,7 @@ void demoMode() {
         }
 
         game.MakeMove(aiMove.x, aiMove.y, player);
+        played.push_back(aiMove);
 
         minX = std::min(minX, aiMove.x - 2);
         maxX = std::max(maxX, aiMove.x + 2);
@@ -350,6 +435,7 @@ void demoMode() {
     }
 
     printBoardWindow(game, minX, maxX, minY, maxY);
+    recordGame(played, winner);
 }
 
 void printMainMenu() {
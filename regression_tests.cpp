@@ -0,0 +1,394 @@
+// regression_tests.cpp — регрессионные тесты поиска: позиции из
+// PositionSuite.hpp на фиксированной глубине, один поток, против
+// сохранённой базы
+//
+// Использование:
+//   regression_tests [--baseline search_baseline.csv] [--update]
+//                    [--timing | --update-timing]
+//                    [--timing-baseline search_timing.csv]
+//                    [--threshold 0.3] [--attempts 3]
+//
+// Однопоточный поиск детерминирован, поэтому лучший ход, оценка и число
+// узлов каждого случая должны совпасть с базой точно; расхождение —
+// изменение поведения поиска, код возврата 1. Эта база не зависит от
+// машины и хранится в репозитории. --update — переписать её текущими
+// результатами после намеренного изменения поиска.
+//
+// --timing добавляет замеры времени. Время — лучший из замеров
+// BenchmarkRunner (он устойчивее медианы к шуму), делённый на время
+// эталонной нагрузки, замеренной тут же перед случаем: так не мешают
+// замедления всей машины на секунды. База времени своя у каждой машины
+// и сборки (--timing-baseline, в репозиторий не кладётся;
+// --update-timing снимает её заново). Рост отношения больше чем в
+// (1 + threshold) раз — регрессия, тоже код возврата 1. Без базы
+// времени замеры только печатаются.
+
+#include "Benchmark.hpp"
+#include "NnueNetwork.hpp"
+#include "PositionSuite.hpp"
+#include "TicTacToe.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// То, что сравнивается с базой: ход, оценка и узлы — точно, время —
+// с порогом и по отдельной базе
+struct RegressionResult {
+    std::string name;
+    Position move;
+    int score = 0;
+    long long nodes = 0;
+    double minNs = 0.0;         // 0 — без замера
+    double relative = 0.0;      // minNs / время эталонной нагрузки
+};
+
+// Размер таблицы задан явно, чтобы база не зависела от значения по
+// умолчанию; небольшой — её очистка входит в каждый замер
+static constexpr std::size_t kTableSize = 1 << 12;
+
+// Эталонная нагрузка: случайные чтения из таблицы в 64 КБ — похоже на
+// пробы доски и таблицы транспозиций, но не зависит от кода движка
+static std::uint64_t ReferenceWork() {
+    static std::uint32_t table[1 << 14];
+    std::uint64_t state = 88172645463325252ULL;
+    std::uint64_t sum = 0;
+    for (int i = 0; i < 20000; ++i) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        std::uint32_t& cell = table[state & ((1 << 14) - 1)];
+        cell += static_cast<std::uint32_t>(state >> 32);
+        sum += cell;
+    }
+    return sum;
+}
+
+static const RegressionResult* FindCase(
+        const DynamicArray<RegressionResult>& cases, const std::string& name) {
+    for (const auto& c : cases) {
+        if (c.name == name) {
+            return &c;
+        }
+    }
+    return nullptr;
+}
+
+// Замеры времени. Случай, медленнее базы больше порога, меряется ещё
+// раз (до attempts попыток) и берётся лучшая: регрессия должна
+// повториться. Без базы времени (--update-timing, новая машина)
+// делаются все попытки.
+struct TimingContext {
+    BenchmarkRunner runner;
+    const DynamicArray<RegressionResult>* baseline = nullptr;
+    double threshold = 0.3;
+    int attempts = 3;
+};
+
+// Один случай: поиск с пустой таблицей транспозиций (иначе повтор шёл
+// бы по «прогретой» таблице), затем, если есть timing, замеры времени
+// эталонной нагрузки и поиска
+template<typename Game, typename Search>
+static void RunCase(DynamicArray<RegressionResult>& results,
+                    TimingContext* timing, const std::string& name,
+                    Game& game, Search search) {
+    RegressionResult r;
+    r.name = name;
+    game.ClearTranspositionTable();
+    r.move = search();
+    r.score = game.GetLastScore();
+    r.nodes = game.GetNodesEvaluated();
+
+    if (timing != nullptr) {
+        const RegressionResult* base =
+            timing->baseline != nullptr ? FindCase(*timing->baseline, name)
+                                        : nullptr;
+        BenchmarkRunner& runner = timing->runner;
+        for (int attempt = 0; attempt < timing->attempts; ++attempt) {
+            runner.Run("reference", []() { DoNotOptimize(ReferenceWork()); });
+            runner.Run(name, [&]() {
+                game.ClearTranspositionTable();
+                DoNotOptimize(search());
+            });
+            const auto& timings = runner.GetResults();
+            const double minNs = timings[timings.size() - 1].minNs;
+            const double relative =
+                minNs / timings[timings.size() - 2].minNs;
+            if (attempt == 0 || relative < r.relative) {
+                r.minNs = minNs;
+                r.relative = relative;
+            }
+            if (base != nullptr &&
+                r.relative <= base->relative * (1.0 + timing->threshold)) {
+                break;
+            }
+        }
+    }
+    results.push_back(r);
+}
+
+static DynamicArray<RegressionResult> RunSuite(TimingContext* timing) {
+    DynamicArray<RegressionResult> results;
+    std::size_t count = 0;
+    const SuitePosition* suite = GetPositionSuite(count);
+    NnueNetwork net = NnueNetwork::CreatePattern(5);
+
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::string name = suite[i].name;
+        DynamicArray<Position> moves;
+        if (!ParseMoveList(suite[i].moves, moves)) {
+            continue;
+        }
+
+        TicTacToeGame game(5);
+        game.SetTranspositionTableSize(kTableSize);
+        const Cell toMove = PlayMoveList(game, moves);
+        if (toMove == EMPTY) {
+            continue;
+        }
+
+        for (int depth = 1; depth <= 3; ++depth) {
+            RunCase(results, timing,
+                    "search/" + name + "/d" + std::to_string(depth), game,
+                    [&]() { return game.FindBestMove(toMove, depth); });
+        }
+
+        BasicTicTacToeGame<5> fixedGame;
+        fixedGame.SetTranspositionTableSize(kTableSize);
+        PlayMoveList(fixedGame, moves);
+        RunCase(results, timing, "search_fixed5/" + name + "/d3", fixedGame,
+                [&]() { return fixedGame.FindBestMove(toMove, 3); });
+
+        RunCase(results, timing, "multipv3/" + name + "/d3", game, [&]() {
+            DynamicArray<PrincipalVariation> lines =
+                game.FindBestMoves(toMove, 3, 3);
+            return lines.empty() ? Position() : lines[0].move;
+        });
+
+        game.SetEvaluator(&net);
+        RunCase(results, timing, "search_nnue/" + name + "/d2", game,
+                [&]() { return game.FindBestMove(toMove, 2); });
+        game.SetEvaluator(nullptr);
+    }
+    return results;
+}
+
+// База точной части: name,x,y,score,nodes; база времени (timing):
+// name,min_ns,relative
+static bool WriteBaseline(const std::string& path,
+                          const DynamicArray<RegressionResult>& results,
+                          bool timing) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out.is_open()) {
+        return false;
+    }
+    out << (timing ? "name,min_ns,relative\n" : "name,x,y,score,nodes\n");
+    for (const auto& r : results) {
+        out << r.name << ',';
+        if (timing) {
+            out << r.minNs << ',' << r.relative << '\n';
+        } else {
+            out << r.move.x << ',' << r.move.y << ',' << r.score << ','
+                << r.nodes << '\n';
+        }
+    }
+    return static_cast<bool>(out);
+}
+
+// false — файл не открылся или в нём ошибка
+static bool ReadBaseline(const std::string& path,
+                         DynamicArray<RegressionResult>& baseline,
+                         bool timing) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        return false;
+    }
+    std::string line;
+    std::getline(in, line);     // заголовок
+    while (std::getline(in, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        std::istringstream fields(line);
+        RegressionResult r;
+        if (!std::getline(fields, r.name, ',')) {
+            return false;
+        }
+        std::string values[4];
+        const int count = timing ? 2 : 4;
+        for (int i = 0; i < count; ++i) {
+            if (!std::getline(fields, values[i], ',')) {
+                return false;
+            }
+        }
+        try {
+            if (timing) {
+                r.minNs = std::stod(values[0]);
+                r.relative = std::stod(values[1]);
+            } else {
+                r.move = Position(std::stoi(values[0]), std::stoi(values[1]));
+                r.score = std::stoi(values[2]);
+                r.nodes = std::stoll(values[3]);
+            }
+        } catch (...) {
+            return false;
+        }
+        baseline.push_back(r);
+    }
+    return true;
+}
+
+// Печатает сравнение по каждому случаю; возвращает число расхождений
+// и регрессий. timingBaseline — nullptr, если время не сравнивается.
+static int Compare(const DynamicArray<RegressionResult>& results,
+                   const DynamicArray<RegressionResult>& baseline,
+                   const DynamicArray<RegressionResult>* timingBaseline,
+                   double threshold) {
+    int failures = 0;
+    for (const auto& r : results) {
+        const RegressionResult* base = FindCase(baseline, r.name);
+        if (base == nullptr) {
+            ++failures;
+            std::cout << "НЕТ В БАЗЕ " << r.name << "\n";
+            continue;
+        }
+
+        if (!(r.move == base->move) || r.score != base->score ||
+            r.nodes != base->nodes) {
+            ++failures;
+            std::cout << "ПОВЕДЕНИЕ  " << r.name << ": ход " << base->move.x
+                      << ',' << base->move.y << " -> " << r.move.x << ','
+                      << r.move.y << ", оценка " << base->score << " -> "
+                      << r.score << ", узлов " << base->nodes << " -> "
+                      << r.nodes << "\n";
+            continue;
+        }
+
+        std::cout << "           " << r.name << ": ход " << r.move.x << ','
+                  << r.move.y << ", оценка " << r.score << ", узлов "
+                  << r.nodes;
+        const RegressionResult* time =
+            timingBaseline != nullptr ? FindCase(*timingBaseline, r.name)
+                                      : nullptr;
+        if (r.relative > 0 && time != nullptr && time->relative > 0) {
+            double ratio = r.relative / time->relative;
+            bool regressed = ratio > 1.0 + threshold;
+            if (regressed) {
+                ++failures;
+            }
+            std::cout << ", " << time->minNs << " -> " << r.minNs
+                      << " нс, относительно эталона x" << ratio
+                      << (regressed ? " РЕГРЕССИЯ" : "");
+        } else if (r.relative > 0) {
+            std::cout << ", " << r.minNs << " нс, относительно эталона "
+                      << r.relative;
+        }
+        std::cout << "\n";
+    }
+
+    for (const auto& b : baseline) {
+        if (FindCase(results, b.name) == nullptr) {
+            ++failures;
+            std::cout << "НЕТ СЛУЧАЯ " << b.name << "\n";
+        }
+    }
+    return failures;
+}
+
+int main(int argc, char** argv) {
+    std::string baselinePath = "search_baseline.csv";
+    std::string timingPath = "search_timing.csv";
+    double threshold = 0.3;
+    bool timing = false;
+    bool update = false;
+    bool updateTiming = false;
+    int attempts = 3;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--baseline" && hasValue) {
+            baselinePath = argv[++i];
+        } else if (arg == "--threshold" && hasValue) {
+            threshold = std::stod(argv[++i]);
+        } else if (arg == "--attempts" && hasValue) {
+            attempts = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--timing-baseline" && hasValue) {
+            timingPath = argv[++i];
+        } else if (arg == "--timing") {
+            timing = true;
+        } else if (arg == "--update") {
+            update = true;
+        } else if (arg == "--update-timing") {
+            timing = true;
+            updateTiming = true;
+        } else {
+            std::cerr << "Неизвестный параметр: " << arg << "\n";
+            return 2;
+        }
+    }
+
+    DynamicArray<RegressionResult> baseline;
+    if (!update && !ReadBaseline(baselinePath, baseline, false)) {
+        std::cerr << "Не удалось прочитать базу " << baselinePath << "\n";
+        return 2;
+    }
+
+    // Базы времени может не быть: на новой машине её ещё не снимали
+    DynamicArray<RegressionResult> timingBaseline;
+    bool hasTimingBaseline = false;
+    if (timing && !updateTiming) {
+        if (std::ifstream(timingPath).is_open()) {
+            if (!ReadBaseline(timingPath, timingBaseline, true)) {
+                std::cerr << "Не удалось прочитать базу времени "
+                          << timingPath << "\n";
+                return 2;
+            }
+            hasTimingBaseline = true;
+        } else {
+            std::cout << "Нет базы времени " << timingPath
+                      << " — замеры только печатаются; снять её: "
+                         "--update-timing\n";
+        }
+    }
+
+    TimingContext context;
+    context.runner.SetQuiet(true);
+    context.baseline = hasTimingBaseline ? &timingBaseline : nullptr;
+    context.threshold = threshold;
+    context.attempts = attempts;
+    DynamicArray<RegressionResult> results =
+        RunSuite(timing ? &context : nullptr);
+
+    if (update) {
+        if (!WriteBaseline(baselinePath, results, false)) {
+            std::cerr << "Не удалось записать " << baselinePath << "\n";
+            return 2;
+        }
+        std::cout << "База обновлена: " << baselinePath << ", случаев "
+                  << results.size() << "\n";
+    } else {
+        int failures = Compare(results, baseline,
+                               hasTimingBaseline ? &timingBaseline : nullptr,
+                               threshold);
+        if (failures != 0) {
+            std::cout << "Расхождений и регрессий: " << failures << "\n";
+            return 1;
+        }
+        std::cout << "Все " << results.size() << " случаев совпали с базой\n";
+    }
+
+    // Замеры пишутся только при совпадении точной части: время другого
+    // поведения поиска сравнивать не с чем
+    if (updateTiming) {
+        if (!WriteBaseline(timingPath, results, true)) {
+            std::cerr << "Не удалось записать " << timingPath << "\n";
+            return 2;
+        }
+        std::cout << "База времени обновлена: " << timingPath << "\n";
+    }
+    return 0;
+}
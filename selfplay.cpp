@@ -0,0 +1,185 @@
+// selfplay.cpp — матч движок против движка без интерфейса
+//
+// Использование (все параметры необязательны):
+//   selfplay games=200 threads=0 seed=1 random=2 maxmoves=40 out=selfplay.csv
+//            a.depth=3 a.root=20 a.width=15 a.tt=1
+//            b.depth=2 b.root=20 b.width=15 b.tt=1
+//            b.engine=mcts b.playouts=20000 b.c=1.0 b.mthreads=1 b.reuse=1
+//            a.nnue=weights.nnue a.weights=eval.weights
+//            trace=selfplay.trace.json record=games.tttg
+//
+// trace= пишет трассу в формате Chrome Trace Event; работает в сборке
+// с -DTTT_TRACE=1. record= дописывает партии в двоичный файл партий
+// (GameRecord.hpp). X.nnue= — оценка сетью из файла весов
+// (NnueNetwork.hpp) вместо оценки по линиям; X.nnue=pattern — встроенная
+// сеть NnueNetwork::CreatePattern. X.weights= — веса оценки по линиям
+// (EvalWeights.hpp, их подбирает tune).
+
+#include "Tournament.hpp"
+
+#include <iostream>
+#include <string>
+
+static bool applyEngineOption(EngineConfig& engine, NnueNetwork& net,
+                              const std::string& key,
+                              const std::string& value) {
+    if (key == "nnue") {
+        if (value == "pattern") {
+            net = NnueNetwork::CreatePattern(5);
+        } else if (!net.Load(value)) {
+            std::cerr << "Не удалось загрузить сеть " << value << "\n";
+            return false;
+        }
+        engine.evaluator = &net;
+    } else if (key == "weights") {
+        if (!engine.weights.Load(value)) {
+            std::cerr << "Не удалось загрузить веса " << value << "\n";
+            return false;
+        }
+    } else if (key == "engine") {
+        if (value == "minimax") {
+            engine.kind = EngineKind::MINIMAX;
+        } else if (value == "mcts") {
+            engine.kind = EngineKind::MCTS;
+        } else {
+            return false;
+        }
+    } else if (key == "playouts") {
+        engine.mcts.iterations = std::stoi(value);
+    } else if (key == "c") {
+        engine.mcts.exploration = std::stod(value);
+    } else if (key == "mthreads") {
+        engine.mcts.threads = static_cast<std::size_t>(std::stoul(value));
+    } else if (key == "reuse") {
+        engine.mcts.reuseTree = (value != "0");
+    } else if (key == "depth") {
+        engine.depth = std::stoi(value);
+    } else if (key == "root") {
+        engine.search.rootWidth = static_cast<std::size_t>(std::stoul(value));
+    } else if (key == "width") {
+        engine.search.nodeWidth = static_cast<std::size_t>(std::stoul(value));
+    } else if (key == "tt") {
+        engine.search.useTranspositionTable = (value != "0");
+    } else {
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    EngineConfig a;
+    EngineConfig b;
+    a.name = "A";
+    b.name = "B";
+    NnueNetwork netA;
+    NnueNetwork netB;
+    TournamentSettings settings;
+    std::string out = "selfplay.csv";
+    std::string tracePath;
+    std::string recordPath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::size_t eq = arg.find('=');
+        if (eq == std::string::npos) {
+            std::cerr << "Ожидался параметр вида ключ=значение: " << arg << "\n";
+            return 1;
+        }
+        std::string key = arg.substr(0, eq);
+        std::string value = arg.substr(eq + 1);
+
+        bool ok = true;
+        if (key.rfind("a.", 0) == 0) {
+            ok = applyEngineOption(a, netA, key.substr(2), value);
+        } else if (key.rfind("b.", 0) == 0) {
+            ok = applyEngineOption(b, netB, key.substr(2), value);
+        } else if (key == "games") {
+            settings.games = std::stoi(value);
+        } else if (key == "threads") {
+            settings.threads = std::stoi(value);
+        } else if (key == "seed") {
+            settings.seed = static_cast<std::uint32_t>(std::stoul(value));
+        } else if (key == "random") {
+            settings.openingRandomMovesLimit = std::stoi(value);
+        } else if (key == "maxmoves") {
+            settings.maxMoves = std::stoi(value);
+        } else if (key == "out") {
+            out = value;
+        } else if (key == "trace") {
+            tracePath = value;
+        } else if (key == "record") {
+            recordPath = value;
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            std::cerr << "Неизвестный параметр: " << key << "\n";
+            return 1;
+        }
+    }
+
+    for (const EngineConfig* engine : { &a, &b }) {
+        if (engine->evaluator != nullptr &&
+            engine->evaluator->GetWinLength() != settings.winLength) {
+            std::cerr << "Сеть " << engine->name << " обучена для линии "
+                      << engine->evaluator->GetWinLength() << ", а не "
+                      << settings.winLength << "\n";
+            return 1;
+        }
+    }
+
+    if (!tracePath.empty()) {
+        if (!Tracer::kCompiled) {
+            std::cerr << "Трассировка не собрана: нужен -DTTT_TRACE=1\n";
+            return 1;
+        }
+        Tracer::Enable(true);
+    }
+
+    GameRecordWriter recorder;
+    if (!recordPath.empty()) {
+        if (!recorder.Open(recordPath)) {
+            std::cerr << "Не удалось открыть " << recordPath << "\n";
+            return 1;
+        }
+        settings.recorder = &recorder;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    DynamicArray<GameResult> results = Tournament::Run(a, b, settings);
+    auto end = std::chrono::steady_clock::now();
+
+    TournamentSummary s = Tournament::Summarize(results);
+    if (!Tournament::WriteCsv(out, results)) {
+        std::cerr << "Не удалось записать " << out << "\n";
+        return 1;
+    }
+
+    std::cout << "Партий: " << results.size() << " за "
+              << std::chrono::duration<double>(end - start).count() << " с\n";
+    std::cout << "A: +" << s.wins << " =" << s.draws << " -" << s.losses
+              << " (очки " << s.score * 100.0 << "%)\n";
+    std::cout << "Elo A-B: " << s.eloDiff << " +/- " << s.eloError << "\n";
+    std::cout << "Среднее время хода: A " << s.aAvgMoveMs << " мс, B "
+              << s.bAvgMoveMs << " мс\n";
+    std::cout << "Результаты партий: " << out << "\n";
+
+    if (!recordPath.empty()) {
+        std::size_t total = recorder.GetGameCount();
+        if (!recorder.Close()) {
+            std::cerr << "Не удалось записать " << recordPath << "\n";
+            return 1;
+        }
+        std::cout << "Партии: " << recordPath << " (всего " << total << ")\n";
+    }
+
+    if (!tracePath.empty()) {
+        if (!Tracer::WriteChromeTrace(tracePath)) {
+            std::cerr << "Не удалось записать " << tracePath << "\n";
+            return 1;
+        }
+        std::cout << "Трасса: " << tracePath << "\n";
+    }
+    return 0;
+}
@@ -1,11 +1,153 @@
 // tests_lab2.cpp — автономные тесты для ЛР-2 (бесконечное поле)
 
+// Тесты собираются с трассировкой, чтобы проверять и её
+#ifndef TTT_TRACE
+#define TTT_TRACE 1
+#endif
+
+#include "AsyncSearch.hpp"
+#include "Tournament.hpp"
+#include "PositionSuite.hpp"
+#include "ConcurrentHashTable.hpp"
+#include "GomocupProtocol.hpp"
+#include "SessionHost.hpp"
+#include "BatchAnalyzer.hpp"
+#include "GameRecord.hpp"
+#include "MctsSearch.hpp"
+#include "NnueNetwork.hpp"
+#include "EvalTuner.hpp"
 #include "TicTacToe.hpp"   // здесь должны быть Position, PositionHash, TicTacToeGame, Cell и т.п.
 // Если HashTable/HashMap в отдельном хедере — раскомментируй и поправь имя:
 // #include "HashTable.hpp"
 
 #include <iostream>
+#include <atomic>
+#include <chrono>
 #include <cassert>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+
+// Счётчик выделений памяти: глобальные operator new/delete подменяются
+// на время всего тестового бинарника, тесты смотрят на разницу показаний.
+// Подменяется весь набор — обычные, массивные, nothrow и выровненные
+// формы: иначе память из библиотечной формы (например, буфер
+// std::stable_sort через nothrow new) освобождалась бы нашим delete.
+// Вся память берётся из malloc/aligned_alloc и возвращается через free.
+static std::atomic<long long> g_allocations{0};
+
+static void* CountedAlloc(std::size_t size, std::size_t alignment) noexcept {
+    ++g_allocations;
+    if (size == 0) {
+        size = 1;
+    }
+    if (alignment <= alignof(std::max_align_t)) {
+        return std::malloc(size);
+    }
+    // aligned_alloc требует размер, кратный выравниванию
+    return std::aligned_alloc(alignment,
+                              (size + alignment - 1) / alignment * alignment);
+}
+
+static void* CountedAllocOrThrow(std::size_t size, std::size_t alignment) {
+    if (void* p = CountedAlloc(size, alignment)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size) {
+    return CountedAllocOrThrow(size, 0);
+}
+
+void* operator new[](std::size_t size) {
+    return CountedAllocOrThrow(size, 0);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return CountedAlloc(size, 0);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return CountedAlloc(size, 0);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return CountedAllocOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return CountedAllocOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment,
+                   const std::nothrow_t&) noexcept {
+    return CountedAlloc(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment,
+                     const std::nothrow_t&) noexcept {
+    return CountedAlloc(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::align_val_t,
+                     const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::align_val_t,
+                       const std::nothrow_t&) noexcept {
+    std::free(p);
+}
 
 class tests_all {
 public:
@@ -17,8 +159,28 @@ public:
         TestWinDetection();
         TestAIMove();
         TestBoundaries();
+        TestOpeningBook();
+        TestAsyncSearch();
+        TestTournament();
+        TestPositionSuite();
+        TestAllocationFreeSearch();
+        TestConcurrentHashTable();
+        TestHashTableBatch();
+        TestFixedWinLength();
+        TestSearchStats();
+        TestTrace();
+        TestGomocupProtocol();
+        TestSessionHost();
+        TestBatchAnalyzer();
+        TestGameRecord();
+        TestMcts();
+        TestNnue();
+        TestEvalTuning();
+        TestMultiPv();
+        TestStagedEvaluation();
+        TestConcurrentHashTableChurn();
 
-        std::cout << "\n=== Все 5/5 тестов пройдены успешно! ===\n";
+        std::cout << "\n=== Все 25/25 тестов пройдены успешно! ===\n";
         std::cout << "(Если бы какой-то тест упал, сработал бы assert)\n\n";
     }
 
@@ -145,6 +307,1620 @@ private:
         assert(game.MakeMove(500, -500, X));
         assert(game.GetCell(500, -500) == X);
 
+        // Край поля: крайние клетки допустимы, дальше — нет
+        assert(game.MakeMove(kMaxCoord, kMinCoord, O));
+        assert(game.GetCell(kMaxCoord, kMinCoord) == O);
+        assert(!game.MakeMove(kMaxCoord + 1, 0, X));
+        assert(!game.MakeMove(0, kMinCoord - 1, X));
+        assert(!game.MakeMove(std::numeric_limits<int>::max(), 0, X));
+        assert(game.GetCell(kMaxCoord + 1, 0) == EMPTY);
+
+        // Упаковка обратима на всём поле
+        const int coords[] = { kMinCoord, -1, 0, 1, kMaxCoord };
+        for (int x : coords) {
+            for (int y : coords) {
+                Position p = PackedPosition::Pack(x, y).Unpack();
+                assert(p.x == x && p.y == y);
+            }
+        }
+
+        // Поиск у края не выходит за поле
+        TicTacToeGame edge(5);
+        edge.MakeMove(kMaxCoord, kMaxCoord, X);
+        edge.MakeMove(kMaxCoord - 1, kMaxCoord, O);
+        Position reply = edge.FindBestMove(X, 2);
+        assert(IsValidCoord(reply.x, reply.y));
+
+        std::cout << "OK\n";
+    }
+
+    static void TestOpeningBook() {
+        std::cout << "Тест 6: Дебютная книга... ";
+
+        const char* path = "test_opening.book";
+
+        DynamicArray<Stone> stones;
+        stones.push_back(Stone(Position(0, 0), X));
+        stones.push_back(Stone(Position(1, 0), O));
+        stones.push_back(Stone(Position(0, 2), X));
+
+        // Лучший ход для X — проигрышный: книга его не предлагает
+        DynamicArray<Stone> losing;
+        losing.push_back(Stone(Position(0, 0), X));
+        losing.push_back(Stone(Position(1, 1), O));
+
+        // Единственная партия — мало для книжного хода
+        DynamicArray<Stone> rare;
+        rare.push_back(Stone(Position(0, 0), X));
+
+        OpeningBookBuilder builder;
+        builder.Record(stones, O, Position(1, 1), 1);
+        builder.Record(stones, O, Position(1, 1), 1);
+        builder.Record(stones, O, Position(-1, 0), -1);
+        builder.Record(losing, X, Position(2, 2), -1);
+        builder.Record(losing, X, Position(2, 2), 0);
+        builder.Record(rare, O, Position(1, 0), 1);
+        assert(builder.Write(path, 8, 5));
+
+        OpeningBook book;
+        assert(book.Open(path));
+        assert(book.GetEntryCount() == 4);
+        assert(book.GetWinLength() == 5);
+
+        Position move;
+        assert(book.Probe(stones, O, move));
+        assert(move.x == 1 && move.y == 1);
+
+        // Та же позиция, повёрнутая на 90° и сдвинутая
+        DynamicArray<Stone> rotated;
+        rotated.push_back(Stone(Position(10, -3), X));
+        rotated.push_back(Stone(Position(10, -2), O));
+        rotated.push_back(Stone(Position(8, -3), X));
+        assert(book.Probe(rotated, O, move));
+        assert(move.x == 9 && move.y == -2);
+
+        // Другой игрок на ходу — позиции в книге нет
+        assert(!book.Probe(stones, X, move));
+
+        assert(!book.Probe(losing, X, move));
+        assert(!book.Probe(rare, O, move));
+        book.SetMinPlays(1);
+        assert(book.Probe(rare, O, move));
+        book.SetMinPlays(OpeningBook::kDefaultMinPlays);
+
+        // FindBestMove берёт ход из книги без поиска
+        TicTacToeGame game(5);
+        game.MakeMove(10, -3, X);
+        game.MakeMove(10, -2, O);
+        game.MakeMove(8, -3, X);
+        game.SetOpeningBook(&book);
+        Position aiMove = game.FindBestMove(O, 2);
+        assert(aiMove.x == 9 && aiMove.y == -2);
+        assert(game.GetNodesEvaluated() == 0);
+
+        // Книжный ход за границей поля не играется
+        BoardBounds bounds;
+        bounds.maxX = 8;
+        game.SetBoardBounds(bounds);
+        aiMove = game.FindBestMove(O, 2);
+        assert(bounds.Contains(aiMove.x, aiMove.y));
+        assert(game.GetNodesEvaluated() > 0);
+
+        // Книга для другой длины линии не подключается
+        TicTacToeGame other(4);
+        assert(!other.SetOpeningBook(&book));
+        assert(other.SetOpeningBook(nullptr));
+
+        book.Close();
+
+        // Число записей в заголовке, при котором размер файла сходится
+        // только по модулю 2^64, — книга не открывается
+        {
+            std::fstream patch(path, std::ios::binary | std::ios::in |
+                                         std::ios::out);
+            OpeningBookHeader header{};
+            patch.read(reinterpret_cast<char*>(&header), sizeof(header));
+            header.entryCount += std::uint64_t(1) << 61;
+            patch.seekp(0);
+            patch.write(reinterpret_cast<const char*>(&header),
+                        sizeof(header));
+        }
+        assert(!book.Open(path));
+        std::filesystem::resize_file(path, sizeof(OpeningBookHeader) + 1);
+        assert(!book.Open(path));
+
+        std::remove(path);
+
+        std::cout << "OK\n";
+    }
+
+    static void TestAsyncSearch() {
+        std::cout << "Тест 7: Фоновый поиск и обдумывание... ";
+
+        TicTacToeGame game(5);
+        game.MakeMove(0, 0, X);
+        game.MakeMove(1, 0, O);
+        game.MakeMove(1, 1, X);
+
+        // Фоновый поиск даёт тот же ход, что и обычный
+        TicTacToeGame reference(game);
+        Position expected = reference.FindBestMove(O, 2);
+
+        AsyncSearch search;
+        search.Start(game, O, 2);
+        Position found = search.Result();
+        assert(search.Poll() && search.IsComplete());
+        assert(found == expected);
+
+        // Обдумывание: угадали ход соперника — ответ уже готов
+        TicTacToeGame predictor(game);
+        Position predicted = predictor.FindBestMove(O, 1);
+        predictor.MakeMove(predicted.x, predicted.y, O);
+        Position expectedReply = predictor.FindBestMove(X, 2);
+
+        search.StartPonder(game, O, X, 2);
+        Position reply;
+        assert(search.PonderHit(predicted, reply));
+        assert(reply == expectedReply);
+
+        // Не угадали — поиск останавливается, ответа нет
+        search.StartPonder(game, O, X, 2);
+        assert(!search.PonderHit(Position(50, 50), reply));
+        assert(!search.IsRunning());
+
+        // Остановка длинного поиска: ход всё равно на свободную клетку
+        search.Start(game, O, 6);
+        search.Stop();
+        assert(search.Poll());
+        assert(search.HasResult());
+        found = search.Result();
+        assert(game.GetCell(found.x, found.y) == EMPTY);
+
+        // Флаг поднят до поиска: ни один корневой ход не досчитан,
+        // возвращается первый кандидат, а не {0, 0} (она занята)
+        std::atomic<bool> stopped(true);
+        TicTacToeGame stoppedGame(game);
+        stoppedGame.SetStopFlag(&stopped);
+        Position first = stoppedGame.GetPossibleMoves()[0];
+        Position fallback = stoppedGame.FindBestMove(O, 3);
+        assert(stoppedGame.WasSearchAborted());
+        assert(fallback == first);
+
+        std::cout << "OK\n";
+    }
+
+    static void TestTournament() {
+        std::cout << "Тест 8: Параллельный матч движков... ";
+
+        // На глубине 2 ширина внутренних узлов влияет на выбор хода
+        EngineConfig a;
+        EngineConfig b;
+        a.depth = 2;
+        b.depth = 2;
+        b.search.nodeWidth = 2;
+
+        TournamentSettings settings;
+        settings.games = 6;
+        settings.threads = 3;
+        settings.maxMoves = 20;
+
+        DynamicArray<GameResult> results = Tournament::Run(a, b, settings);
+        assert(results.size() == 6);
+
+        // Партии детерминированы: повторный прогон даёт те же исходы
+        DynamicArray<GameResult> again = Tournament::Run(a, b, settings);
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            assert(results[i].index == static_cast<int>(i));
+            assert(results[i].aIsX == (i % 2 == 0));
+            assert(results[i].outcome == again[i].outcome);
+            assert(results[i].plies == again[i].plies);
+        }
+
+        // Настройка B действительно меняет партии: матч A против копии A
+        // идёт иначе
+        DynamicArray<GameResult> mirror = Tournament::Run(a, a, settings);
+        bool differs = false;
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            differs = differs || results[i].outcome != mirror[i].outcome ||
+                      results[i].plies != mirror[i].plies;
+        }
+        assert(differs);
+
+        TournamentSummary s = Tournament::Summarize(results);
+        assert(s.wins + s.draws + s.losses == 6);
+
+        assert(Tournament::EloFromScore(0.5) == 0.0);
+        assert(Tournament::EloFromScore(0.75) > 190.0 &&
+               Tournament::EloFromScore(0.75) < 191.0);
+
+        std::cout << "OK\n";
+    }
+
+    static void TestPositionSuite() {
+        std::cout << "Тест 9: Разбор записи партии и набор позиций... ";
+
+        DynamicArray<Position> moves;
+        assert(ParseMoveList("0,0 -1,2  3,-4", moves));
+        assert(moves.size() == 3);
+        assert(moves[1] == Position(-1, 2));
+        assert(!ParseMoveList("0,0 1", moves));
+        assert(!ParseMoveList("a,b", moves));
+
+        TicTacToeGame game(5);
+        assert(ParseMoveList("0,0 1,0 0,1", moves));
+        assert(PlayMoveList(game, moves) == O);
+        assert(game.GetCell(1, 0) == O);
+
+        // Повтор хода в занятую клетку
+        TicTacToeGame bad(5);
+        assert(ParseMoveList("0,0 0,0", moves));
+        assert(PlayMoveList(bad, moves) == EMPTY);
+
+        // Все позиции набора корректны и партия в них не закончена
+        std::size_t count = 0;
+        const SuitePosition* suite = GetPositionSuite(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            TicTacToeGame g(5);
+            assert(ParseMoveList(suite[i].moves, moves));
+            assert(PlayMoveList(g, moves) != EMPTY);
+            assert(!g.CheckWin(X) && !g.CheckWin(O));
+        }
+
+        std::cout << "OK\n";
+    }
+
+    static void TestAllocationFreeSearch() {
+        std::cout << "Тест 10: Поиск без выделений памяти... ";
+
+        TicTacToeGame game(5);
+        game.MakeMove(0, 0, X);
+        game.MakeMove(1, 0, O);
+        game.MakeMove(1, 1, X);
+        game.MakeMove(2, 2, O);
+
+        // Первый поиск выделяет таблицу транспозиций и буферы
+        Position first = game.FindBestMove(X, 3);
+        game.MakeMove(first.x, first.y, X);
+        game.MakeMove(-1, -1, O);
+
+        long long before = g_allocations.load();
+        Position second = game.FindBestMove(X, 3);
+        long long allocations = g_allocations.load() - before;
+
+        assert(allocations == 0);
+        assert(game.GetCell(second.x, second.y) == EMPTY);
+
+        // MakeMove/UndoMove восстанавливают доску и ключ позиции
+        SearchState state;
+        PositionHash ph;
+        HashTable<Position, Cell> board(16, [&ph](const Position& p) {
+            return ph(p);
+        });
+        board.Add(Position(0, 0), X);
+        board.Add(Position(3, -2), O);
+        state.Load(board, 5, 4);
+
+        std::uint64_t hash = state.Hash();
+        state.MakeMove(Position(1, 1), O);
+        state.MakeMove(Position(2, 2), X);
+        assert(state.At(1, 1) == O && state.At(2, 2) == X);
+        assert(state.Hash() != hash);
+        state.UndoMove();
+        state.UndoMove();
+        assert(state.At(1, 1) == EMPTY && state.At(2, 2) == EMPTY);
+        assert(state.At(3, -2) == O);
+        assert(state.Hash() == hash);
+        assert(state.GetStoneCount() == 2);
+
+        // const-запросы не делят состояние: одновременные чтения одной
+        // партии из нескольких потоков дают то же, что и из одного
+        const TicTacToeGame& shared = game;
+        const int expectedX = shared.EvaluatePosition(X);
+        const std::size_t expectedMoves = shared.GetPossibleMoves().size();
+        std::atomic<int> mismatches{0};
+        DynamicArray<std::thread> readers;
+        for (int t = 0; t < 4; ++t) {
+            readers.push_back(std::thread([&]() {
+                for (int i = 0; i < 200; ++i) {
+                    if (shared.EvaluatePosition(X) != expectedX ||
+                        shared.GetPossibleMoves().size() != expectedMoves ||
+                        shared.CheckWin(X) || shared.CheckWin(O)) {
+                        ++mismatches;
+                    }
+                }
+            }));
+        }
+        for (auto& reader : readers) {
+            reader.join();
+        }
+        assert(mismatches.load() == 0);
+
+        std::cout << "OK\n";
+    }
+
+    static void TestConcurrentHashTable() {
+        std::cout << "Тест 11: Конкурентная хеш-таблица... ";
+
+        PositionHash ph;
+        auto hashFunc = [ph](const Position& p) { return ph(p); };
+
+        // Тот же сценарий, что и для HashTable
+        ConcurrentHashTable<Position, int> ht(16, hashFunc, 4);
+        ht.Add(Position(5, 10), 1);
+        ht.Add(Position(-3, 7), 2);
+        ht.Add(Position(100, -50), 3);
+        assert(ht.GetCount() == 3);
+        assert(ht.Get(Position(-3, 7)) == 2);
+        assert(!ht.ContainsKey(Position(999, 999)));
+        ht.Add(Position(-3, 7), 20);
+        assert(ht.Get(Position(-3, 7)) == 20);
+        ht.Remove(Position(-3, 7));
+        assert(!ht.ContainsKey(Position(-3, 7)));
+        assert(ht.GetCount() == 2);
+        assert(ht.GetKeys().size() == 2);
+
+        // Нагрузка: писатели добавляют и удаляют свои ключи (таблица
+        // при этом растёт), читатели проверяют неизменные ключи
+        ConcurrentHashTable<Position, int> shared(8, hashFunc, 8);
+        const int stable = 256;
+        for (int i = 0; i < stable; ++i) {
+            shared.Add(Position(i, 0), i * 7);
+        }
+
+        std::atomic<bool> failed(false);
+        std::atomic<int> writersDone(0);
+        const int writers = 2;
+        DynamicArray<std::thread> threads;
+
+        for (int w = 0; w < writers; ++w) {
+            threads.push_back(std::thread([&shared, &writersDone, w]() {
+                for (int round = 0; round < 20; ++round) {
+                    for (int i = 0; i < 200; ++i) {
+                        shared.Add(Position(i, w + 1), round);
+                    }
+                    for (int i = 0; i < 200; ++i) {
+                        shared.Remove(Position(i, w + 1));
+                    }
+                }
+                ++writersDone;
+            }));
+        }
+        for (int r = 0; r < 2; ++r) {
+            threads.push_back(std::thread([&, r]() {
+                do {
+                    for (int i = r; i < stable; i += 2) {
+                        if (shared.Get(Position(i, 0)) != i * 7) {
+                            failed = true;
+                        }
+                    }
+                } while (writersDone.load() < writers);
+            }));
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        assert(!failed.load());
+        assert(shared.GetCount() == static_cast<std::size_t>(stable));
+
+        std::cout << "OK\n";
+    }
+
+    static void TestHashTableBatch() {
+        std::cout << "Тест 12: Пакетный поиск в хеш-таблице... ";
+
+        PositionHash ph;
+        auto hashFunc = [&ph](const Position& p) { return ph(p); };
+        HashTable<Position, int> ht(64, hashFunc);
+        for (int i = 0; i < 100; ++i) {
+            ht.Add(Position(i, -i), i);
+        }
+
+        // Больше одной порции, попадания вперемешку с промахами
+        const std::size_t n = 50;
+        Position keys[n];
+        for (std::size_t i = 0; i < n; ++i) {
+            int k = static_cast<int>(i) * 3;
+            keys[i] = (i % 2 == 0) ? Position(k, -k) : Position(k, k + 1);
+        }
+
+        bool contains[n];
+        ht.ContainsBatch(keys, n, contains);
+
+        bool found[n];
+        int values[n];
+        for (std::size_t i = 0; i < n; ++i) {
+            values[i] = -1;
+        }
+        std::size_t hits = ht.GetBatch(keys, n, values, found);
+
+        std::size_t expectedHits = 0;
+        for (std::size_t i = 0; i < n; ++i) {
+            bool present = ht.ContainsKey(keys[i]);
+            assert(contains[i] == present);
+            assert(found[i] == present);
+            assert(values[i] == (present ? ht.Get(keys[i]) : -1));
+            expectedHits += present ? 1 : 0;
+        }
+        assert(hits == expectedHits);
+        assert(hits == 17);
+
+        ht.ContainsBatch(keys, 0, contains);
+
+        std::cout << "OK\n";
+    }
+
+    static void TestFixedWinLength() {
+        std::cout << "Тест 13: Длина линии при компиляции... ";
+
+        // Поиск с ядрами-константами совпадает с обычным
+        std::size_t count = 0;
+        const SuitePosition* suite = GetPositionSuite(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            DynamicArray<Position> moves;
+            assert(ParseMoveList(suite[i].moves, moves));
+
+            TicTacToeGame dynamic(5);
+            BasicTicTacToeGame<5> fixed;
+            Cell toMove = PlayMoveList(dynamic, moves);
+            assert(PlayMoveList(fixed, moves) == toMove);
+
+            assert(fixed.EvaluatePosition(toMove) ==
+                   dynamic.EvaluatePosition(toMove));
+            Position a = dynamic.FindBestMove(toMove, 2);
+            Position b = fixed.FindBestMove(toMove, 2);
+            assert(a == b);
+            assert(dynamic.GetNodesEvaluated() == fixed.GetNodesEvaluated());
+        }
+
+        // Короткая линия и длина без своего ядра (общий путь)
+        BasicTicTacToeGame<3> three;
+        three.MakeMove(0, 0, X);
+        three.MakeMove(1, 1, X);
+        assert(!three.CheckWin(X));
+        three.MakeMove(2, 2, X);
+        assert(three.CheckWin(X));
+
+        TicTacToeGame seven(7);
+        for (int i = 0; i < 6; ++i) {
+            seven.MakeMove(i, -i, O);
+        }
+        assert(!seven.CheckWin(O));
+        seven.MakeMove(6, -6, O);
+        assert(seven.CheckWin(O));
+
+        bool thrown = false;
+        try {
+            BasicTicTacToeGame<5> wrong(4);
+        } catch (const std::invalid_argument&) {
+            thrown = true;
+        }
+        assert(thrown);
+
+        std::cout << "OK\n";
+    }
+
+    static void TestSearchStats() {
+        std::cout << "Тест 14: Статистика поиска... ";
+
+        TicTacToeGame game(5);
+        game.MakeMove(0, 0, X);
+        game.MakeMove(1, 0, O);
+        game.MakeMove(0, 1, X);
+        game.MakeMove(1, 1, O);
+        (void)game.FindBestMove(X, 3);
+
+        const SearchStats& stats = game.GetSearchStats();
+        if (SearchStats::kEnabled) {
+            assert(stats.depth == 3);
+            assert(stats.nodesPerPly[0] == 1);
+            long long sum = 0;
+            for (std::size_t ply = 0; ply < SearchStats::kMaxPly; ++ply) {
+                sum += stats.nodesPerPly[ply];
+            }
+            assert(sum == stats.nodes);
+
+            // Старый счётчик: вызовы Minimax (все узлы, кроме корня)
+            // плюс оценки в листьях
+            assert(game.GetNodesEvaluated() ==
+                   stats.nodes - 1 + stats.leafEvaluations);
+            assert(stats.cutoffs > 0);
+            assert(stats.firstMoveCutoffs <= stats.cutoffs);
+            assert(stats.EffectiveBranchingFactor() > 1.0);
+            assert(stats.totalNs >= stats.evalNs);
+        } else {
+            assert(stats.nodes == 0);
+        }
+
+        std::cout << "OK\n";
+    }
+
+    static void TestTrace() {
+        std::cout << "Тест 15: Трассировка поиска... ";
+
+        if (!Tracer::kCompiled) {
+            std::cout << "пропущен (TTT_TRACE=0)\n";
+            return;
+        }
+
+        const std::size_t capacity = 64;
+        Tracer::SetBufferCapacity(capacity);
+        Tracer::Enable(true);
+
+        auto search = []() {
+            TicTacToeGame game(5);
+            game.MakeMove(0, 0, X);
+            game.MakeMove(1, 0, O);
+            game.MakeMove(0, 1, X);
+            (void)game.FindBestMove(O, 2);
+        };
+        std::thread worker([&search]() {
+            Tracer::SetThreadName("test \"worker\"");
+            search();
+        });
+        search();
+        worker.join();
+        Tracer::Enable(false);
+
+        std::ostringstream out;
+        assert(Tracer::WriteChromeTrace(out));
+        const std::string json = out.str();
+        assert(json.find("\"traceEvents\"") != std::string::npos);
+        assert(json.find("\"FindBestMove\"") != std::string::npos);
+        assert(json.find("\"RootMove\"") != std::string::npos);
+        assert(json.find("test \\\"worker\\\"") != std::string::npos);
+
+        // Буферы кольцевые: событий не больше ёмкости на поток
+        std::size_t events = 0;
+        for (std::size_t at = json.find("\"ph\":\"X\"");
+             at != std::string::npos;
+             at = json.find("\"ph\":\"X\"", at + 1)) {
+            ++events;
+        }
+        assert(events > 0 && events <= 2 * capacity);
+
+        Tracer::Clear();
+        std::ostringstream empty;
+        assert(Tracer::WriteChromeTrace(empty));
+        assert(empty.str().find("\"ph\":\"X\"") == std::string::npos);
+
+        std::cout << "OK\n";
+    }
+
+    static void TestGomocupProtocol() {
+        std::cout << "Тест 16: Протокол Gomocup... ";
+
+        // Команды подаются построчно, как их присылала бы оболочка
+        GomocupEngine engine;
+        std::istringstream noInput;
+        auto send = [&engine, &noInput](const std::string& command) {
+            std::ostringstream out;
+            assert(engine.HandleCommand(command, noInput, out));
+            return out.str();
+        };
+        auto parseMove = [](const std::string& reply, int& x, int& y) {
+            char comma = 0;
+            std::istringstream in(reply);
+            return static_cast<bool>(in >> x >> comma >> y) && comma == ',';
+        };
+
+        assert(send("TURN 1,1").rfind("ERROR", 0) == 0);
+        assert(send("START 15") == "OK\n");
+        send("INFO timeout_turn 200");
+        send("INFO max_memory 16777216");
+
+        // Первый ход — в центр поля
+        int x = -1, y = -1;
+        assert(parseMove(send("BEGIN"), x, y));
+        assert(x == 7 && y == 7);
+
+        // Срок хода — лимит минус запас, а при малом остатке времени
+        // матча — его доля
+        assert(engine.GetMoveBudget() == std::chrono::milliseconds(170));
+        send("INFO time_left 1000");
+        assert(engine.GetMoveBudget() == std::chrono::milliseconds(20));
+        send("INFO time_left 100000");
+
+        // Ответ — законный ход хотя бы полной первой глубины
+        assert(parseMove(send("TURN 8,8"), x, y));
+        assert(x >= 0 && x < 15 && y >= 0 && y < 15);
+        assert(engine.GetGame().GetCell(x, y) == X);
+        assert(engine.GetGame().GetCompletedDepth() >= 1);
+
+        // Срок уже вышел: первая глубина не прерывается, следующая не
+        // начинается. С запасом времени поиск доходит ровно до maxDepth.
+        TicTacToeGame timed(5);
+        timed.MakeMove(0, 0, X);
+        timed.MakeMove(1, 1, O);
+        Position quick = timed.FindBestMoveTimed(X,
+                                                 std::chrono::milliseconds(0));
+        assert(timed.GetCompletedDepth() == 1);
+        assert(timed.GetCell(quick.x, quick.y) == EMPTY);
+        Position deep = timed.FindBestMoveTimed(X, std::chrono::hours(1), 2);
+        assert(timed.GetCompletedDepth() == 2);
+        assert(!timed.WasSearchAborted());
+        assert(deep == timed.FindBestMove(X, 2));
+
+        // Новые границы очищают таблицу транспозиций: повторный поиск
+        // не берёт оценок, посчитанных для другого поля
+        timed.ClearTranspositionTable();
+        assert(timed.FindBestMove(X, 2) == deep);
+        long long coldNodes = timed.GetNodesEvaluated();
+        assert(timed.FindBestMove(X, 2) == deep);
+        assert(timed.GetNodesEvaluated() < coldNodes);
+        timed.SetBoardBounds(timed.GetBoardBounds());
+        assert(timed.FindBestMove(X, 2) == deep);
+        assert(timed.GetNodesEvaluated() == coldNodes);
+
+        assert(send("TURN 8,8").rfind("ERROR", 0) == 0);     // занято
+        assert(send("TURN 15,3").rfind("ERROR", 0) == 0);    // вне доски
+        assert(send("TAKEBACK 8,8") == "OK\n");
+        assert(engine.GetGame().GetCell(8, 8) == EMPTY);
+        assert(send("FOO").rfind("UNKNOWN", 0) == 0);
+
+        // BOARD: четыре наших камня у края доски — ход должен замкнуть
+        // пятёрку с единственной свободной стороны
+        std::istringstream board(
+            "0,5,1\n1,5,1\n2,5,1\n3,5,1\n"
+            "5,5,2\n0,6,2\n1,6,2\n2,6,2\nDONE\n");
+        std::ostringstream out;
+        assert(engine.HandleCommand("BOARD", board, out));
+        assert(parseMove(out.str(), x, y));
+        assert(x == 4 && y == 5);
+        assert(engine.GetGame().CheckWin(X));
+
+        // Полный сценарий через Run, включая END
+        std::istringstream script("RECTSTART 20,10\r\nBEGIN\r\nEND\r\n");
+        std::ostringstream transcript;
+        GomocupEngine second;
+        second.Run(script, transcript);
+        assert(transcript.str() == "OK\n9,4\n");
+
+        std::cout << "OK\n";
+    }
+
+    static void TestSessionHost() {
+        std::cout << "Тест 17: Много партий в одном процессе... ";
+
+        std::atomic<int> answered(0);
+        {
+            std::mutex resultsMutex;
+            DynamicArray<SessionHost::MoveResult> results;
+            SessionHost host(2, 2);
+            const int sessions = 40;
+            DynamicArray<SessionHost::SessionId> ids;
+            for (int i = 0; i < sessions; ++i) {
+                SessionHost::SessionId id = host.CreateSession();
+                assert(host.Play(id, 0, 0, X));
+                assert(host.Play(id, i % 4 + 1, 1, O));
+                ids.push_back(id);
+            }
+            assert(host.GetSessionCount() == sessions);
+            assert(!host.Play(ids[0], 0, 0, O));        // занято
+            std::size_t before = host.GetTotalSessionMemory();
+            assert(host.GetSessionMemory(ids[0]) > 0);
+
+            for (auto id : ids) {
+                assert(host.RequestMove(id, X, std::chrono::milliseconds(200),
+                    [&](const SessionHost::MoveResult& r) {
+                        std::lock_guard<std::mutex> lock(resultsMutex);
+                        results.push_back(r);
+                        ++answered;
+                    }));
+            }
+            while (answered.load() < sessions) {
+                std::this_thread::yield();
+            }
+
+            // Сколько глубин успели — зависит от загрузки машины; ход
+            // в любом случае законный, а отметка о сроке согласована
+            // с задержкой (срок — 200 мс от запроса). Все ответы уже
+            // пришли, обработчики больше не вызываются.
+            assert(results.size() == static_cast<std::size_t>(sessions));
+            for (const auto& r : results) {
+                assert(r.depth >= 0 && r.depth <= 2);
+                assert(r.deadlineMissed == (r.latencyMs > 200.0));
+
+                // Ход движка записан в сессию, на пустую клетку
+                DynamicArray<Stone> stones = host.GetStones(r.session);
+                assert(stones.size() == 3);
+                assert(stones[2].cell == X && stones[2].pos == r.move);
+                assert(!(stones[2].pos == stones[0].pos));
+                assert(!(stones[2].pos == stones[1].pos));
+            }
+
+            assert(host.CloseSession(ids[1]));
+            assert(!host.CloseSession(ids[1]));
+            assert(host.GetSessionCount() == sessions - 1);
+            assert(host.GetSessionMemory(ids[1]) == 0);
+            assert(host.GetTotalSessionMemory() > 0);
+            assert(host.GetTotalSessionMemory() != before);
+        }
+
+        // Очередь: пока единственный рабочий занят, запросы копятся и
+        // затем выполняются по сроку, а не по порядку поступления
+        {
+            SessionHost host(1, 1);
+            SessionHost::SessionId blocker = host.CreateSession();
+            SessionHost::SessionId late = host.CreateSession();
+            SessionHost::SessionId urgent = host.CreateSession();
+
+            std::atomic<bool> release(false);
+            std::atomic<bool> blocked(false);
+            std::mutex orderMutex;
+            DynamicArray<SessionHost::SessionId> order;
+            auto record = [&](const SessionHost::MoveResult& r) {
+                std::lock_guard<std::mutex> lock(orderMutex);
+                order.push_back(r.session);
+            };
+
+            assert(host.RequestMove(blocker, X, std::chrono::seconds(1),
+                [&](const SessionHost::MoveResult&) {
+                    blocked = true;
+                    while (!release.load()) {
+                        std::this_thread::yield();
+                    }
+                }));
+            while (!blocked.load()) {
+                std::this_thread::yield();
+            }
+
+            assert(host.RequestMove(late, X, std::chrono::seconds(2), record));
+            assert(host.RequestMove(urgent, X, std::chrono::seconds(1),
+                                    record));
+            // У сессии не больше одного запроса
+            assert(!host.RequestMove(late, X, std::chrono::seconds(1), record));
+            assert(!host.Play(late, 5, 5, O));
+            assert(host.GetQueueLength() == 2);
+
+            release = true;
+            while (true) {
+                std::lock_guard<std::mutex> lock(orderMutex);
+                if (order.size() == 2) {
+                    break;
+                }
+            }
+            assert(order[0] == urgent && order[1] == late);
+        }
+
+        std::cout << "OK\n";
+    }
+    // Строки CSV без последнего поля (время)
+    static DynamicArray<std::string> withoutTime(const std::string& csv) {
+        DynamicArray<std::string> lines;
+        std::istringstream in(csv);
+        std::string line;
+        while (std::getline(in, line)) {
+            lines.push_back(line.substr(0, line.rfind(',')));
+        }
+        return lines;
+    }
+
+    static void TestBatchAnalyzer() {
+        std::cout << "Тест 18: Пакетный анализ позиций... ";
+
+        std::size_t suiteCount = 0;
+        const SuitePosition* suite = GetPositionSuite(suiteCount);
+
+        // Позиции набора по кругу, между ними пропуски и ошибки
+        std::string input = "# комментарий\n";
+        std::size_t positions = 0;
+        for (int round = 0; round < 3; ++round) {
+            for (std::size_t i = 0; i < suiteCount; ++i) {
+                input += std::string(suite[i].moves) + "\n";
+                ++positions;
+            }
+            input += "\n";
+            input += "0,0 0,0\n";                         // занятая клетка
+            input += "1;2\n";                             // не разбирается
+            input += "0,0 0,1 1,0 1,1 2,0 2,1 3,0 3,1 4,0\n";  // X уже выиграл
+            positions += 3;
+        }
+
+        AnalysisSettings settings;
+        settings.depth = 2;
+
+        // Ожидаемое — последовательный анализ на одной партии
+        std::ostringstream expected;
+        BatchAnalyzer::WriteHeader(expected);
+        {
+            TicTacToeGame game(settings.winLength);
+            std::istringstream in(input);
+            std::string line;
+            std::size_t number = 0;
+            while (std::getline(in, line)) {
+                ++number;
+                if (line.empty() || line[0] == '#') {
+                    continue;
+                }
+                BatchAnalyzer::WriteResult(
+                    expected, BatchAnalyzer::Analyze(game, line, number,
+                                                     settings));
+            }
+        }
+
+        // Окно меньше числа потоков и больше — порядок и результаты те же
+        for (std::size_t window : { std::size_t(2), std::size_t(16) }) {
+            settings.threads = 4;
+            settings.window = window;
+            std::istringstream in(input);
+            std::ostringstream out;
+            assert(BatchAnalyzer::Run(in, out, settings) == positions);
+
+            DynamicArray<std::string> got = withoutTime(out.str());
+            DynamicArray<std::string> want = withoutTime(expected.str());
+            assert(got.size() == positions + 1);
+            assert(got.size() == want.size());
+            for (std::size_t i = 0; i < got.size(); ++i) {
+                assert(got[i] == want[i]);
+            }
+        }
+
+        // Номера строк считаются с пропущенными; ошибки не мешают остальным
+        std::istringstream in("\n0,0 0,0\n0,0 1,0\n");
+        std::ostringstream out;
+        settings.threads = 2;
+        settings.window = 0;
+        assert(BatchAnalyzer::Run(in, out, settings) == 2);
+        DynamicArray<std::string> lines = withoutTime(out.str());
+        assert(lines.size() == 3);
+        assert(lines[1].rfind("2,invalid,", 0) == 0);
+        assert(lines[2].rfind("3,ok,X,", 0) == 0);
+
+        std::cout << "OK\n";
+    }
+    static void TestGameRecord() {
+        std::cout << "Тест 19: Двоичный файл партий... ";
+
+        const char* path = "test_games.tttg";
+        std::remove(path);
+
+        // Партия 0 — победа X, партия 1 — ничья с дальними ходами
+        DynamicArray<Position> win;
+        for (int i = 0; i < 5; ++i) {
+            win.push_back(Position(i, 0));
+            if (i < 4) {
+                win.push_back(Position(i, 1));
+            }
+        }
+        DynamicArray<Position> far;
+        far.push_back(Position(-16000, 16000));
+        far.push_back(Position(16000, -16000));
+        far.push_back(Position(0, 0));
+
+        {
+            GameRecordWriter writer;
+            assert(writer.Open(path));
+            assert(writer.Append(win, 5, X));
+            assert(writer.Append(far, 5, EMPTY));
+            assert(writer.Close());
+        }
+        // Дописывание в существующий файл: индекс переписывается
+        {
+            GameRecordWriter writer;
+            assert(writer.Open(path));
+            assert(writer.GetGameCount() == 2);
+            assert(writer.Append(win, 4, O));
+        }
+
+        // Соседние ходы — по 2 байта, дальние — по 6
+        std::error_code error;
+        std::uintmax_t size = std::filesystem::file_size(path, error);
+        assert(!error);
+        assert(size == sizeof(GameFileHeader) +
+                       3 * sizeof(GameRecordHeader) + 2 * (2 * win.size()) +
+                       6 * far.size() + 3 * sizeof(std::uint64_t) +
+                       sizeof(GameIndexFooter));
+
+        GameRecordReader reader;
+        assert(reader.Open(path));
+        assert(reader.GetGameCount() == 3);
+
+        DynamicArray<Position> moves;
+        GameRecordView view = reader.GetGame(0);
+        assert(view.GetPlies() == win.size());
+        assert(view.GetWinner() == X && view.GetWinLength() == 5);
+        assert(view.GetMoves(moves));
+        for (std::size_t i = 0; i < win.size(); ++i) {
+            assert(moves[i] == win[i]);
+        }
+        assert(reader.GetGame(1).GetMoves(moves));
+        assert(moves.size() == 3 && moves[1] == far[1]);
+        assert(reader.GetGame(2).GetWinner() == O);
+        assert(reader.GetGame(2).GetWinLength() == 4);
+
+        // Расстановка на доске: вся партия и её начало
+        TicTacToeGame game(5);
+        assert(reader.Replay(0, game) == O);
+        assert(game.CheckWin(X));
+        assert(reader.Replay(0, game, 4) == X);
+        assert(!game.CheckWin(X));
+        assert(game.GetCell(1, 1) == O && game.GetCell(2, 0) == EMPTY);
+        assert(reader.Replay(1, game) == O);
+        assert(game.GetCell(-16000, 16000) == X);
+        reader.Close();
+
+        // Без индекса (процесс упал) партии находятся проходом по файлу,
+        // а обрезанная последняя партия отбрасывается
+        std::filesystem::resize_file(
+            path, size - sizeof(GameIndexFooter) - 3 * sizeof(std::uint64_t) - 1);
+        assert(reader.Open(path));
+        assert(reader.GetGameCount() == 2);
+        reader.Close();
+        {
+            GameRecordWriter writer;
+            assert(writer.Open(path));
+            assert(writer.GetGameCount() == 2);
+            assert(writer.Append(far, 5, EMPTY));
+        }
+        assert(reader.Open(path));
+        assert(reader.GetGameCount() == 3);
+        assert(reader.GetGame(2).GetMoves(moves) && moves[0] == far[0]);
+        reader.Close();
+
+        // Сбой посреди Close: за партиями — мусор вместо индекса. Записи
+        // с нулевой длиной линии, чужим победителем или ходом за полем
+        // партиями не считаются.
+        size = std::filesystem::file_size(path, error);
+        assert(!error);
+        const std::uintmax_t dataEnd =
+            size - sizeof(GameIndexFooter) - 3 * sizeof(std::uint64_t);
+        const unsigned char garbage[][8] = {
+            { 1, 0, 0, 0, 0, 0, 0, 0 },             // длина линии 0
+            { 1, 0, 5, 7, 0, 0, 0, 0 },             // победитель 7
+            { 1, 0, 5, 1, 0x80, 0x80, 0x08, 0 },    // x = 65536 — за полем
+        };
+        for (const auto& junk : garbage) {
+            std::filesystem::resize_file(path, dataEnd);
+            {
+                std::ofstream out(path, std::ios::binary | std::ios::app);
+                out.write(reinterpret_cast<const char*>(junk), sizeof(junk));
+            }
+            assert(reader.Open(path));
+            assert(reader.GetGameCount() == 3);
+            reader.Close();
+        }
+        {
+            GameRecordWriter writer;
+            assert(writer.Open(path));
+            assert(writer.GetGameCount() == 3);
+        }
+        assert(std::filesystem::file_size(path, error) == size);
+
+        // Испорченная разность в партии из индекса: ход за полем,
+        // а не переполнение int. Первая разность x дальней партии —
+        // три байта varint, заменяем её числом той же длины.
+        std::remove(path);
+        {
+            GameRecordWriter writer;
+            assert(writer.Open(path));
+            assert(writer.Append(far, 5, EMPTY));
+            assert(writer.Close());
+        }
+        {
+            std::fstream patch(path, std::ios::binary | std::ios::in |
+                                         std::ios::out);
+            const unsigned char huge[3] = { 0xff, 0xff, 0x7f };
+            patch.seekp(sizeof(GameFileHeader) + sizeof(GameRecordHeader));
+            patch.write(reinterpret_cast<const char*>(huge), sizeof(huge));
+        }
+        assert(reader.Open(path));
+        assert(reader.GetGameCount() == 1);
+        assert(!reader.GetGame(0).GetMoves(moves));
+        assert(reader.Replay(0, game) == EMPTY);
+        reader.Close();
+
+        // Подвал индекса, не сходящийся с размером файла (в том числе
+        // через переполнение смещения), — файл испорчен
+        auto writeFooter = [path](std::uint64_t gameCount,
+                                  std::uint64_t indexOffset,
+                                  std::size_t padding) {
+            GameFileHeader fileHeader{};
+            std::memcpy(fileHeader.magic, record_detail::kMagic,
+                        sizeof(fileHeader.magic));
+            fileHeader.version = record_detail::kVersion;
+            GameIndexFooter footer{};
+            footer.gameCount = gameCount;
+            footer.indexOffset = indexOffset;
+            std::memcpy(footer.magic, record_detail::kIndexMagic,
+                        sizeof(footer.magic));
+            std::ofstream out(path, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(&fileHeader),
+                      sizeof(fileHeader));
+            const std::string zeros(padding, '\0');
+            out.write(zeros.data(), static_cast<std::streamsize>(padding));
+            out.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+        };
+        // 48 байт: 6 * 8 + 24 + смещение 48 - 24 - 48 (по модулю 2^64)
+        writeFooter(6, 48 - 24 - 48, 8);
+        assert(!reader.Open(path));
+        // Индекс оборван: две записи в подвале, одна в файле
+        writeFooter(2, sizeof(GameFileHeader), 8);
+        assert(!reader.Open(path));
+        // Хвост индекса не кратен 8
+        writeFooter(1, sizeof(GameFileHeader), 12);
+        assert(!reader.Open(path));
+        {
+            GameRecordWriter writer;
+            assert(!writer.Open(path));
+        }
+
+        std::remove(path);
+        std::cout << "OK\n";
+    }
+    static void TestMcts() {
+        std::cout << "Тест 20: Поиск Монте-Карло по дереву... ";
+
+        MctsSettings settings;
+        settings.iterations = 3000;
+        settings.nodeCapacity = 1 << 16;
+
+        // Четыре X в ряд, слева закрыто: X выигрывает, O закрывает справа
+        TicTacToeGame game(5);
+        for (int i = 0; i < 4; ++i) {
+            game.MakeMove(i, 0, X);
+        }
+        game.MakeMove(-1, 0, O);
+        game.MakeMove(0, 2, O);
+        game.MakeMove(2, -2, O);
+        {
+            MctsSearch mcts(settings);
+            Position win = mcts.FindBestMove(game, X);
+            assert(win.x == 4 && win.y == 0);
+            Position block = mcts.FindBestMove(game, O);
+            assert(block.x == 4 && block.y == 0);
+        }
+
+        // Несколько потоков на одном дереве: все плейауты учтены
+        TicTacToeGame open(5);
+        open.MakeMove(0, 0, X);
+        open.MakeMove(1, 1, O);
+        open.MakeMove(1, 0, X);
+        settings.threads = 3;
+        MctsSearch mcts(settings);
+        Position move = mcts.FindBestMove(open, O);
+        assert(open.GetCell(move.x, move.y) == EMPTY);
+        assert(mcts.GetLastIterations() == settings.iterations);
+        assert(mcts.GetRootVisits() == settings.iterations);
+        assert(mcts.GetReusedVisits() == 0);
+
+        // Ход и ответ из дерева: статистика переносится
+        open.MakeMove(move.x, move.y, O);
+        Position reply(move.x + 1, move.y);
+        if (open.GetCell(reply.x, reply.y) != EMPTY) {
+            reply = Position(move.x - 1, move.y);
+        }
+        open.MakeMove(reply.x, reply.y, X);
+        move = mcts.FindBestMove(open, O);
+        assert(open.GetCell(move.x, move.y) == EMPTY);
+        assert(mcts.GetReusedVisits() > 0);
+        assert(mcts.GetRootVisits() ==
+               mcts.GetReusedVisits() + settings.iterations);
+
+        // Позиция не из дерева — поиск с нуля
+        open.MakeMove(move.x, move.y, O);
+        open.MakeMove(20, 20, X);
+        move = mcts.FindBestMove(open, O);
+        assert(mcts.GetReusedVisits() == 0);
+
+        // Плейауты не выделяют память: число выделений за поиск не
+        // зависит от числа плейаутов
+        settings.threads = 1;
+        settings.reuseTree = false;
+        MctsSettings longer = settings;
+        longer.iterations = 10 * settings.iterations;
+        MctsSearch shortSearch(settings);
+        MctsSearch longSearch(longer);
+        (void)shortSearch.FindBestMove(open, O);
+        (void)longSearch.FindBestMove(open, O);
+
+        long long before = g_allocations.load();
+        (void)shortSearch.FindBestMove(open, O);
+        long long shortAllocations = g_allocations.load() - before;
+        before = g_allocations.load();
+        (void)longSearch.FindBestMove(open, O);
+        long long longAllocations = g_allocations.load() - before;
+        assert(longSearch.GetLastIterations() == longer.iterations);
+        assert(shortAllocations == longAllocations);
+
+        std::cout << "OK\n";
+    }
+    static bool SameAccumulator(const NnueAccumulator& a,
+                                const NnueAccumulator& b) {
+        return std::memcmp(a.values, b.values, sizeof(a.values)) == 0 &&
+               a.completed[0] == b.completed[0] &&
+               a.completed[1] == b.completed[1];
+    }
+
+    static void TestNnue() {
+        std::cout << "Тест 21: Оценка сетью (NNUE)... ";
+
+        // Сеть со случайными весами
+        NnueNetwork net(5);
+        std::uint32_t seed = 12345;
+        auto next = [&seed]() {
+            seed = seed * 1103515245u + 12345u;
+            return static_cast<int>((seed >> 16) & 0x7fff);
+        };
+        for (int f = 0; f < net.GetFeatureCount(); ++f) {
+            for (int h = 0; h < NnueNetwork::kHidden; ++h) {
+                net.SetFeatureWeight(f, h,
+                                     static_cast<std::int16_t>(next() % 61 - 30));
+            }
+        }
+        for (int h = 0; h < NnueNetwork::kHidden; ++h) {
+            net.SetHiddenBias(h, static_cast<std::int16_t>(next() % 41 - 10));
+        }
+        for (int i = 0; i < 2 * NnueNetwork::kHidden; ++i) {
+            net.SetOutputWeight(i, static_cast<std::int8_t>(next() % 255 - 127));
+        }
+        net.SetOutputBias(-17);
+        net.SetOutputScale(3, 4);
+
+        // Инкрементальный аккумулятор совпадает с посчитанным с нуля —
+        // и после ходов, и после их отмены
+        SearchState state;
+        state.SetNetwork(&net);
+        DynamicArray<Stone> stones;
+        stones.push_back(Stone(Position(0, 0), X));
+        stones.push_back(Stone(Position(1, 1), O));
+        stones.push_back(Stone(Position(2, 0), X));
+        state.Load(stones, 5, 8);
+        auto at = [&state](int x, int y) { return state.At(x, y); };
+        NnueAccumulator fresh;
+        net.Refresh(fresh, state.GetStones(), at);
+        assert(SameAccumulator(fresh, state.GetAccumulator()));
+        NnueAccumulator start = state.GetAccumulator();
+
+        const Position line[] = {
+            Position(1, 0), Position(-1, 1), Position(3, 0), Position(2, 2),
+            Position(4, 0), Position(0, 3)
+        };
+        for (int i = 0; i < 6; ++i) {
+            state.MakeMove(line[i], i % 2 == 0 ? X : O);
+            net.Refresh(fresh, state.GetStones(), at);
+            assert(SameAccumulator(fresh, state.GetAccumulator()));
+        }
+        // X: 0..4 по y = 0 — линия собрана, проверка по счётчику окон
+        // совпадает с обходом доски
+        assert(state.CheckWinNnue(X) && state.CheckWin(X));
+        assert(!state.CheckWinNnue(O) && !state.CheckWin(O));
+        assert(state.EvaluateNnue(X) == NnueNetwork::kWinScore);
+        for (int i = 0; i < 6; ++i) {
+            state.UndoMove();
+        }
+        assert(SameAccumulator(start, state.GetAccumulator()));
+
+        // Векторное и скалярное ядра дают одно и то же, в том числе на
+        // значениях за пределами 0..127
+        NnueNetwork scalar = net;
+        scalar.SetUseSimd(false);
+        NnueAccumulator acc;
+        for (int round = 0; round < 100; ++round) {
+            for (int side = 0; side < 2; ++side) {
+                for (int h = 0; h < NnueNetwork::kHidden; ++h) {
+                    acc.values[side][h] =
+                        static_cast<std::int16_t>(next() % 400 - 100);
+                }
+            }
+            assert(net.Evaluate(acc, X) == scalar.Evaluate(acc, X));
+            assert(net.Evaluate(acc, O) == scalar.Evaluate(acc, O));
+        }
+        SearchState scalarState;
+        scalarState.SetNetwork(&scalar);
+        scalarState.Load(stones, 5, 8);
+        scalarState.MakeMove(Position(1, 0), X);
+        state.MakeMove(Position(1, 0), X);
+        assert(SameAccumulator(scalarState.GetAccumulator(),
+                               state.GetAccumulator()));
+        state.UndoMove();
+
+        // Файл весов: сохранение и загрузка, чужой файл отклоняется
+        const char* path = "test_nnue.bin";
+        assert(net.Save(path));
+        NnueNetwork loaded(3);
+        assert(loaded.Load(path));
+        assert(loaded.GetWinLength() == 5);
+        assert(loaded.Evaluate(start, X) == net.Evaluate(start, X));
+        assert(loaded.Evaluate(start, O) == net.Evaluate(start, O));
+        {
+            std::ofstream bad(path, std::ios::binary | std::ios::trunc);
+            bad << "not a network file at all, definitely not";
+        }
+        assert(!loaded.Load(path));
+        assert(loaded.GetWinLength() == 5);
+        std::remove(path);
+        assert(!loaded.Load(path));
+
+        // Партия с сетью: выигрывает и закрывает четвёрку, как с оценкой
+        // по линиям; сеть для другой длины линии не принимается
+        NnueNetwork pattern = NnueNetwork::CreatePattern(5);
+        TicTacToeGame game(5);
+        SearchConfig wide;
+        wide.rootWidth = 64;
+        wide.nodeWidth = 64;
+        game.SetSearchConfig(wide);
+        game.SetEvaluator(&pattern);
+        for (int i = 0; i < 4; ++i) {
+            game.MakeMove(i, 0, X);
+        }
+        game.MakeMove(-1, 0, O);
+        game.MakeMove(0, 2, O);
+        game.MakeMove(2, -2, O);
+        Position win = game.FindBestMove(X, 2);
+        assert(win.x == 4 && win.y == 0);
+        Position block = game.FindBestMove(O, 2);
+        assert(block.x == 4 && block.y == 0);
+        TicTacToeGame copy(game);
+        assert(copy.GetEvaluator() == &pattern);
+        assert(copy.EvaluatePosition(X) == game.EvaluatePosition(X));
+
+        NnueNetwork other(4);
+        bool rejected = false;
+        try {
+            game.SetEvaluator(&other);
+        } catch (const std::invalid_argument&) {
+            rejected = true;
+        }
+        assert(rejected && game.GetEvaluator() == &pattern);
+
+        std::cout << "OK\n";
+    }
+    static void TestEvalTuning() {
+        std::cout << "Тест 22: Веса оценки и их подбор... ";
+
+        // Веса по умолчанию — прежние константы
+        EvalWeights defaults;
+        assert(defaults.winScore == 10000);
+        assert(defaults.LineScore(3) == 90 && defaults.LineScore(9) == 810);
+
+        // Файл весов: запись и чтение, частичный файл, ошибки
+        const char* path = "test_eval.weights";
+        EvalWeights doubled;
+        doubled.winScore = 20000;
+        for (int c = 0; c < EvalWeights::kMaxLineCount; ++c) {
+            doubled.lineScores[c] = 2 * defaults.lineScores[c];
+        }
+        assert(doubled.Save(path));
+        EvalWeights loaded;
+        assert(loaded.Load(path) && loaded == doubled);
+        {
+            std::ofstream out(path, std::ios::trunc);
+            out << "# только очки за выигрыш\nwin 500\n";
+        }
+        loaded = EvalWeights();
+        assert(loaded.Load(path));
+        assert(loaded.winScore == 500 && loaded.LineScore(4) == 160);
+        {
+            std::ofstream out(path, std::ios::trunc);
+            out << "line 0 10 сорок\n";
+        }
+        assert(!loaded.Load(path) && loaded.winScore == 500);
+        // Движок Gomocup перечитывает изменившийся файл перед партией
+        assert(doubled.Save(path));
+        {
+            GomocupEngine engine(path);
+            std::istringstream in;
+            std::ostringstream out;
+            assert(engine.GetEvalWeights() == defaults);
+            engine.HandleCommand("START 15", in, out);
+            assert(engine.GetEvalWeights() == doubled);
+            assert(defaults.Save(path));
+            std::filesystem::last_write_time(
+                path, std::filesystem::last_write_time(path) +
+                          std::chrono::seconds(1));
+            engine.HandleCommand("RESTART", in, out);
+            assert(engine.GetEvalWeights() == defaults);
+        }
+        std::remove(path);
+        assert(!loaded.Load(path));
+
+        // Оценка с весами: удвоенные веса — удвоенная оценка, и по
+        // линиям, и за выигрыш; копия партии сохраняет веса
+        TicTacToeGame game(5);
+        game.MakeMove(0, 0, X);
+        game.MakeMove(1, 1, O);
+        game.MakeMove(1, 0, X);
+        game.MakeMove(5, 5, O);
+        game.MakeMove(2, 0, X);
+        int base = game.EvaluatePosition(X);
+        assert(base != 0);
+        game.SetEvalWeights(doubled);
+        assert(game.EvaluatePosition(X) == 2 * base);
+        TicTacToeGame copy(game);
+        assert(copy.GetEvalWeights() == doubled);
+        game.MakeMove(3, 0, X);
+        game.MakeMove(4, 0, X);
+        assert(game.EvaluatePosition(O) == -20000);
+        game.SetEvalWeights(EvalWeights());
+
+        // Признаки подбора: оценка — их скалярное произведение с весами
+        SearchState state;
+        state.Load(copy.GetStones(), 5, 1);
+        int counts[10];
+        state.CountLines(X, counts, 10);
+        int dot = 0;
+        for (int c = 0; c < 10; ++c) {
+            dot += counts[c] * defaults.lineScores[c];
+        }
+        assert(dot == base);
+
+        // Подбор по записанным партиям: ошибка падает, результат не
+        // зависит от числа потоков
+        const char* gamesPath = "test_tuning.tttg";
+        std::remove(gamesPath);
+        {
+            GameRecordWriter writer;
+            assert(writer.Open(gamesPath));
+            EngineConfig a;
+            EngineConfig b;
+            a.depth = 1;
+            b.depth = 1;
+            b.search.nodeWidth = 5;
+            TournamentSettings settings;
+            settings.games = 12;
+            settings.threads = 2;
+            settings.openingRandomMovesLimit = 4;
+            settings.recorder = &writer;
+            (void)Tournament::Run(a, b, settings);
+            assert(writer.Close());
+        }
+        GameRecordReader reader;
+        assert(reader.Open(gamesPath));
+
+        EvalTuner single(5);
+        EvalTuner parallel(5);
+        std::size_t positions = single.AddGames(reader, 2, 1);
+        assert(positions > 0);
+        assert(parallel.AddGames(reader, 2, 3) == positions);
+
+        TuneSettings tune;
+        tune.iterations = 40;
+        tune.batchSize = 16;
+        tune.regularization = 0.0;
+        tune.learningRate = 1.0;
+        EvalWeights tunedSingle;
+        EvalWeights tunedParallel;
+        tune.threads = 1;
+        TuneReport r1 = single.Tune(tunedSingle, tune);
+        tune.threads = 3;
+        TuneReport r2 = parallel.Tune(tunedParallel, tune);
+        assert(tunedSingle == tunedParallel);
+        assert(r1.scale == r2.scale && r1.finalLoss == r2.finalLoss);
+        assert(r1.finalLoss < r1.initialLoss);
+        assert(tunedSingle.winScore == defaults.winScore);
+
+        reader.Close();
+        std::remove(gamesPath);
+        std::cout << "OK\n";
+    }
+    static void TestMultiPv() {
+        std::cout << "Тест 23: Несколько лучших ходов (multi-PV)... ";
+
+        SearchConfig config;
+        config.rootWidth = 12;
+        config.nodeWidth = 12;
+        TicTacToeGame game(5);
+        game.SetSearchConfig(config);
+        game.MakeMove(0, 0, X);
+        game.MakeMove(1, 1, O);
+        game.MakeMove(1, 0, X);
+        game.MakeMove(2, 2, O);
+        game.MakeMove(-1, 1, X);
+        const int depth = 3;
+
+        // Все ходы корня: оценка каждого совпадает с отдельным поиском
+        // за соперника после этого хода (оценка антисимметрична)
+        DynamicArray<PrincipalVariation> all =
+            game.FindBestMoves(O, depth, 100);
+        assert(all.size() == config.rootWidth);
+        for (std::size_t i = 0; i < all.size(); ++i) {
+            if (i > 0) {
+                assert(all[i - 1].score >= all[i].score);
+            }
+            TicTacToeGame after(game);
+            after.MakeMove(all[i].move.x, all[i].move.y, O);
+            (void)after.FindBestMove(X, depth - 1);
+            assert(all[i].score == -after.GetLastScore());
+        }
+
+        // Первые K линий — те же, первая — ход и оценка FindBestMove
+        game.ClearTranspositionTable();
+        DynamicArray<PrincipalVariation> three =
+            game.FindBestMoves(O, depth, 3);
+        assert(three.size() == 3);
+        for (std::size_t i = 0; i < three.size(); ++i) {
+            assert(three[i].move == all[i].move);
+            assert(three[i].score == all[i].score);
+        }
+        long long threeNodes = game.GetSearchStats().nodes;
+        game.ClearTranspositionTable();
+        Position best = game.FindBestMove(O, depth);
+        assert(best == three[0].move);
+        assert(game.GetLastScore() == three[0].score);
+        game.ClearTranspositionTable();
+        DynamicArray<PrincipalVariation> one = game.FindBestMoves(O, depth, 1);
+        assert(one.size() == 1 && one[0].move == best);
+        // Меньше линий — меньше узлов: остальные ходы отсекаются окном
+        assert(game.GetSearchStats().nodes <= threeNodes);
+        assert(game.GetCompletedDepth() == depth);
+
+        // Главный вариант: законные ходы по очереди; полный вариант
+        // приводит в лист с той же оценкой
+        bool fullLine = false;
+        for (const auto& pv : three) {
+            assert(!pv.line.empty() && pv.line[0] == pv.move);
+            assert(pv.line.size() <= static_cast<std::size_t>(depth));
+            TicTacToeGame replay(game);
+            Cell turn = O;
+            for (const auto& m : pv.line) {
+                assert(replay.MakeMove(m.x, m.y, turn));
+                turn = (turn == X) ? O : X;
+            }
+            if (pv.line.size() == static_cast<std::size_t>(depth)) {
+                fullLine = true;
+                assert(replay.EvaluatePosition(O) == pv.score);
+            }
+        }
+        assert(fullLine);
+
+        // Выигрыш в один ход — первая линия с оценкой выигрыша
+        TicTacToeGame win(5);
+        for (int i = 0; i < 4; ++i) {
+            win.MakeMove(i, 0, X);
+            win.MakeMove(i, 3, O);
+        }
+        DynamicArray<PrincipalVariation> wins = win.FindBestMoves(X, 2, 2);
+        assert(wins.size() == 2);
+        assert(wins[0].score == 10000 && wins[0].line.size() == 1);
+        assert(win.FindBestMoves(X, 2, 0).empty());
+
+        std::cout << "OK\n";
+    }
+
+    static void TestStagedEvaluation() {
+        std::cout << "Тест 24: Оценка по ступеням... ";
+
+        // Эталон — сумма линий по CountLines и полный обход CheckWin
+        auto reference = [](const SearchState& state, Cell player) {
+            const EvalWeights& weights = state.GetEvalWeights();
+            if (state.CheckWin(X)) {
+                return player == X ? weights.winScore : -weights.winScore;
+            }
+            if (state.CheckWin(O)) {
+                return player == O ? weights.winScore : -weights.winScore;
+            }
+            int counts[EvalWeights::kMaxLineCount];
+            const int size = 2 * state.GetWinLength();
+            state.CountLines(player, counts, size);
+            int score = 0;
+            for (int c = 0; c < size; ++c) {
+                score += counts[c] * weights.lineScores[c];
+            }
+            return score;
+        };
+
+        // Случайные спуски и откаты: оценка и флаги линий на каждом
+        // уровне совпадают с полным пересчётом
+        std::uint64_t random = 12345;
+        auto next = [&random]() {
+            random = random * 6364136223846793005ULL + 1442695040888963407ULL;
+            return static_cast<std::size_t>(random >> 33);
+        };
+        for (int winLength : {3, 5, 7}) {
+            SearchState state;
+            state.Load(DynamicArray<Stone>(), winLength, 64,
+                       BoardBounds{-6, -6, 6, 6});
+            EvalWeights weights;
+            weights.lineScores[2] = 35;
+            weights.lineScores[3] = -7;
+            int checked = 0;
+            for (int walk = 0; walk < 40; ++walk) {
+                const std::size_t length = 6 + next() % 30;
+                for (std::size_t ply = 0; ply < length; ++ply) {
+                    const DynamicArray<Position>& moves =
+                        state.GenerateMoves(ply);
+                    // Копия: MakeMove может перестроить буферы
+                    const Position move = moves[next() % moves.size()];
+                    state.MakeMove(move, (state.GetStoneCount() % 2) ? O : X);
+                    assert(state.HasLine(X) == state.CheckWin(X));
+                    assert(state.HasLine(O) == state.CheckWin(O));
+                    if (next() % 3 != 0) {
+                        Cell player = (next() % 2) ? X : O;
+                        assert(state.Evaluate(player) ==
+                               reference(state, player));
+                        ++checked;
+                    }
+                }
+                // Смена весов сбрасывает запомненные суммы
+                if (walk == 20) {
+                    state.SetEvalWeights(weights);
+                }
+                for (std::size_t i = 0; i < length; ++i) {
+                    state.UndoMove();
+                    assert(state.Evaluate(X) == reference(state, X));
+                    assert(state.HasLine(X) == state.CheckWin(X));
+                }
+            }
+            assert(checked > 100);
+            assert(state.GetEvalWeights() == weights);
+        }
+
+        // Загрузка позиции с уже собранной линией
+        DynamicArray<Stone> stones;
+        for (int i = 0; i < 5; ++i) {
+            stones.push_back(Stone(Position(i, i), O));
+        }
+        SearchState loaded;
+        loaded.Load(stones, 5, 1);
+        assert(loaded.HasLine(O) && !loaded.HasLine(X));
+        assert(loaded.EvaluateFixed<5>(X) == -10000);
+
+        std::cout << "OK\n";
+    }
+
+    static void TestConcurrentHashTableChurn() {
+        std::cout << "Тест 25: Освобождение памяти при чередовании Add/Remove... ";
+
+        // Писатели добавляют и удаляют ключи по кругу: надгробия
+        // заставляют шарды перестраиваться снова и снова. Старые массивы
+        // освобождаются, как только их не читают, — выделенная память
+        // не растёт с числом записей.
+        PositionHash ph;
+        auto hashFunc = [&ph](const Position& p) { return ph(p); };
+        ConcurrentHashTable<Position, int> table(8, hashFunc, 4);
+        const int stable = 64;
+        for (int i = 0; i < stable; ++i) {
+            table.Add(Position(i, 0), i);
+        }
+
+        const int writers = 2;
+        const int churnKeys = 100;
+        // Все ключи сразу, с запасом на загрузку 1/4 и перекос шардов
+        const std::size_t bound = 16 * (stable + writers * churnKeys);
+        std::atomic<bool> failed(false);
+        std::atomic<int> writersDone(0);
+        std::atomic<std::size_t> peak(0);
+        DynamicArray<std::thread> threads;
+
+        for (int w = 0; w < writers; ++w) {
+            threads.push_back(std::thread([&, w]() {
+                for (int round = 0; round < 300; ++round) {
+                    for (int i = 0; i < churnKeys; ++i) {
+                        table.Add(Position(i, w + 1), round);
+                    }
+                    for (int i = 0; i < churnKeys; ++i) {
+                        table.Remove(Position(i, w + 1));
+                    }
+                }
+                ++writersDone;
+            }));
+        }
+        for (int r = 0; r < 2; ++r) {
+            threads.push_back(std::thread([&]() {
+                do {
+                    for (int i = 0; i < stable; ++i) {
+                        if (table.Get(Position(i, 0)) != i) {
+                            failed = true;
+                        }
+                    }
+                    std::size_t slots = table.GetAllocatedSlots();
+                    std::size_t seen = peak.load();
+                    while (slots > seen &&
+                           !peak.compare_exchange_weak(seen, slots)) {
+                    }
+                } while (writersDone.load() < writers);
+            }));
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        assert(!failed.load());
+        assert(table.GetCount() == static_cast<std::size_t>(stable));
+        assert(table.GetAllocatedSlots() == table.GetCapacity());
+        assert(peak.load() <= bound);
+
         std::cout << "OK\n";
     }
 };
@@ -0,0 +1,115 @@
+// tune.cpp — подбор весов оценки по линиям по записанным партиям
+//
+// Использование (все параметры необязательны):
+//   tune in=games.tttg out=eval.weights init= win=5 skip=4 threads=0
+//        batch=4096 iterations=300 rate=2 scale=0 reg=1e-6
+//
+// in — файл партий (GameRecord.hpp, например из selfplay record=);
+// несколько файлов — через запятую. init — начальные веса (по умолчанию
+// count * count * 10). scale=0 — подобрать K сигмоиды по начальным
+// весам; reg — штраф за отход от начальных весов. Результат —
+// текстовый файл весов (EvalWeights.hpp), который движки загружают без
+// пересборки: selfplay a.weights=, analyze weights=, gomocup
+// перечитывает eval.weights перед каждой партией.
+
+#include "EvalTuner.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+int main(int argc, char** argv) {
+    std::string inPaths = "games.tttg";
+    std::string outPath = "eval.weights";
+    std::string initPath;
+    int winLength = 5;
+    int skipPlies = 4;
+    TuneSettings settings;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::size_t eq = arg.find('=');
+        if (eq == std::string::npos) {
+            std::cerr << "Ожидался параметр вида ключ=значение: " << arg << "\n";
+            return 1;
+        }
+        std::string key = arg.substr(0, eq);
+        std::string value = arg.substr(eq + 1);
+
+        bool ok = true;
+        if (key == "in") {
+            inPaths = value;
+        } else if (key == "out") {
+            outPath = value;
+        } else if (key == "init") {
+            initPath = value;
+        } else if (key == "win") {
+            winLength = std::stoi(value);
+        } else if (key == "skip") {
+            skipPlies = std::stoi(value);
+        } else if (key == "threads") {
+            settings.threads = static_cast<std::size_t>(std::stoul(value));
+        } else if (key == "batch") {
+            settings.batchSize = static_cast<std::size_t>(std::stoul(value));
+        } else if (key == "iterations") {
+            settings.iterations = std::stoi(value);
+        } else if (key == "rate") {
+            settings.learningRate = std::stod(value);
+        } else if (key == "scale") {
+            settings.scale = std::stod(value);
+        } else if (key == "reg") {
+            settings.regularization = std::stod(value);
+        } else {
+            ok = false;
+        }
+
+        if (!ok || winLength <= 0 || settings.iterations < 0) {
+            std::cerr << "Неверный параметр: " << arg << "\n";
+            return 1;
+        }
+    }
+
+    EvalWeights weights;
+    if (!initPath.empty() && !weights.Load(initPath)) {
+        std::cerr << "Не удалось загрузить веса " << initPath << "\n";
+        return 1;
+    }
+
+    EvalTuner tuner(winLength);
+    auto start = std::chrono::steady_clock::now();
+    std::istringstream paths(inPaths);
+    std::string path;
+    while (std::getline(paths, path, ',')) {
+        GameRecordReader reader;
+        if (!reader.Open(path)) {
+            std::cerr << "Не удалось открыть " << path << "\n";
+            return 1;
+        }
+        std::size_t added = tuner.AddGames(reader, skipPlies,
+                                           settings.threads);
+        std::cout << path << ": партий " << reader.GetGameCount()
+                  << ", позиций " << added << "\n";
+    }
+    if (tuner.GetPositionCount() == 0) {
+        std::cerr << "Нет позиций для подбора\n";
+        return 1;
+    }
+    auto extracted = std::chrono::steady_clock::now();
+
+    TuneReport report = tuner.Tune(weights, settings, &std::cout);
+    auto end = std::chrono::steady_clock::now();
+
+    if (!weights.Save(outPath, 2 * winLength)) {
+        std::cerr << "Не удалось записать " << outPath << "\n";
+        return 1;
+    }
+    std::cout << "Признаки: "
+              << std::chrono::duration<double>(extracted - start).count()
+              << " с, подбор: "
+              << std::chrono::duration<double>(end - extracted).count()
+              << " с\n";
+    std::cout << "Веса: " << outPath << " (ошибка " << report.initialLoss
+              << " -> " << report.finalLoss << ")\n";
+    return 0;
+}